@@ -1,6 +1,7 @@
 // Decode logic for the Fluke 1900A DOU.
 
 #include "dou.c"
+#include "si.c"
 
 #define NUMBER_OF_DIGITS 6
 #define MAX_UNIT_LENGTH  4
@@ -31,9 +32,19 @@
 
 enum unit { ms, us, MHz, kHz, NoUnit };
 
-static const char unit_texts_[5][MAX_UNIT_LENGTH] = {"ms", "us", "Mhz", "kHz",
+static const char unit_texts_[5][MAX_UNIT_LENGTH] = {"ms", "us", "MHz", "kHz",
                                                      ""};
 
+// The SI base unit and decimal exponent of each unit.
+static const struct {
+  i8 exponent;
+  u8 base; // `enum si_unit`
+} unit_si_[5] = {[ms] = {-3, SI_SECOND},
+                 [us] = {-6, SI_SECOND},
+                 [MHz] = {6, SI_HERTZ},
+                 [kHz] = {3, SI_HERTZ},
+                 [NoUnit] = {0, SI_NONE}};
+
 static char *print_unit(char *const begin, const char *end,
                         const enum unit value) {
   return print_str(begin, end, unit_texts_[value]);
@@ -53,9 +64,12 @@ struct decoder_state {
   // point.
   u32 reading;
   int next_digit;
-  int decimal_point_digit;
+  int decimal_point_digit; // that was strobed with DS, 1 = MSD, or 0
 };
 
+// `next_digit` after a reading, until the end of its memory update
+#define UPDATE_END (-1)
+
 static struct decoder_state decode(const struct decoder_state state,
                                    const unsigned input) {
   switch (state.next_digit) {
@@ -64,21 +78,13 @@ static struct decoder_state decode(const struct decoder_state state,
       return (struct decoder_state){0U, 1, 0};
     }
     return state;
-  case 1:
-    if ((input & INPUT_nMUP) != 0U) {
-      return (struct decoder_state){0U, 0, 0};
-    }
-    if (input & INPUT_AS6) {
-      return (struct decoder_state){DCBA(input), 2,
-                                    IS_DECIMAL_POINT(input) ? 6 : 0};
-    }
-    return state;
   // Initially, wait for the `AS_6` strobe that indicates the most significant
   // digit (MSD). This ensures that decoding starts with the first complete
   // block of digits (MSD to LSD) while `nMUP` is low.
   //  For each strobe, the corresponding digit is captured and appended to the
   // reading. If the decimal strobe is asserted during a digit strobe, the
   // decimal point is appended to the reading.
+  case 1:
   case 2:
   case 3:
   case 4:
@@ -98,20 +104,91 @@ static struct decoder_state decode(const struct decoder_state state,
                                     state.decimal_point_digit};
     }
     return state;
+  case UPDATE_END:
+    // The digits are scanned repeatedly while nMUP is low, but only the first
+    // scan is taken, so that there is one reading per gate time.
+    if ((input & INPUT_nMUP) != 0U) {
+      return (struct decoder_state){0U, 0, 0};
+    }
+    return state;
   }
 }
 
+// Between memory updates, the display keeps showing the latest reading. To
+// get a reading right after a reset rather than after up to the longest gate
+// time, the held reading can be decoded by ignoring nMUP. A memory update
+// during that pass may mix old and new digits, so this shall only be used for
+// the first reading.
+#define HELD_INPUT(input) ((input) & ~(unsigned)INPUT_nMUP)
+#ifndef LOCK_ON_START
+#define LOCK_ON_START 1
+#endif
+
+// Converts a reading of the decoder, including its decimal point, to SI units.
+static struct si_value reading_to_si(const u32 reading, const enum unit unit) {
+  return si_from_bcd(reading, unit_si_[unit].exponent, unit_si_[unit].base);
+}
+
 static char *print_reading(char buf[static MAX_READING_SIZE], const u32 reading,
                            const int decimal_point_digit, const bool overflow,
                            const enum unit unit) {
-  buf[NUMBER_OF_DIGITS + 1 - decimal_point_digit] = '.';
+  const char *end = &buf[MAX_READING_SIZE - 1];
   buf[0] = overflow ? '>' : ' ';
-
   const int num_chars = NUMBER_OF_DIGITS + (decimal_point_digit != 0);
-  int i = 0;
-  for (; i < num_chars; ++i) {
-    buf[1 + i] = DIGIT(reading, num_chars - i);
+  for (int i = 0; i < num_chars; ++i) {
+    buf[1 + i] = bcd2digit(DIGIT(reading, num_chars - 1 - i));
+  }
+  char *dst = print_unit(&buf[1 + num_chars], end, unit);
+  dst = print_str(dst, end, "\r\n");
+  *dst = '\0';
+  return dst;
+}
+
+// The largest output is that of the burst format.
+#define MAX_OUTPUT_SIZE MAX_BURST_SIZE
+_Static_assert(MAX_READING_SIZE <= MAX_OUTPUT_SIZE, "output buffer too small");
+_Static_assert(MAX_CSV_SIZE <= MAX_OUTPUT_SIZE, "output buffer too small");
+
+// For the burst format, the overflow flag and the unit are packed above the
+// digits and the decimal point, which take 28 bits at most.
+#define BURST_OVERFLOW   (0x80000000U)
+#define BURST_UNIT(unit) ((u32)(unit) << 28U)
+
+// Packs a reading of the decoder with its overflow flag and unit into one
+// word, as for the burst format. It is never all ones, as the unit is not.
+static u32 pack_reading(const u32 reading, const bool overflow,
+                        const enum unit unit) {
+  return reading | (overflow ? BURST_OVERFLOW : 0U) | BURST_UNIT(unit);
+}
+
+// ACLK ticks per tenth of a second, the unit of `config.burst_deadline`, with
+// ACLK at nominally 1.5 kHz.
+#define DEADLINE_TICKS 150U
+
+// Prints the reading in the configured format, including the line ending.
+// Returns false, if there is nothing to send, because the average or the burst
+// is not complete yet.
+static bool print_output(char buf[static MAX_OUTPUT_SIZE],
+                         const struct config *config,
+                         struct si_average *average, struct burst *burst,
+                         const u32 reading, const int decimal_point_digit,
+                         const bool overflow, const enum unit unit,
+                         const u16 sequence, const u32 timestamp) {
+  if (config->format == FORMAT_FIXED) {
+    print_reading(buf, reading, decimal_point_digit, overflow, unit);
+    return true;
+  }
+  if (config->format == FORMAT_BURST) {
+    return burst_add(buf, burst, pack_reading(reading, overflow, unit),
+                     sequence, timestamp, config->burst_size,
+                     (u32)config->burst_deadline * DEADLINE_TICKS);
+  }
+  struct si_value mean;
+  bool overload;
+  if (!si_average_add(average, reading_to_si(reading, unit), overflow,
+                      config->averaging, &mean, &overload)) {
+    return false;
   }
-  return print_str(print_unit(&buf[i], &buf[MAX_READING_SIZE], unit),
-                   &buf[MAX_READING_SIZE], "\r\n");
+  print_value(buf, config->format, mean, overload, sequence, timestamp);
+  return true;
 }
@@ -0,0 +1,84 @@
+// Benchmarks the 1900A capture path, i.e. `decode()` and `print_reading()`,
+// on simulated bus activity with the shortest gate time, and checks that each
+// memory update gives its reading.
+
+#include "1900a_sim.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define GATE_US      10000U // the shortest gate time, 10 ms
+#define NUM_GATES    4096U
+#define NUM_PASSES   64U
+
+static double seconds_since(const struct timespec *start) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  return (double)(now.tv_sec - start->tv_sec) +
+         (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// Returns a display of random digits, decimal point and unit.
+static struct sim_display random_display(void) {
+  static const unsigned levels[] = {0U, INPUT_NML, INPUT_RNG2,
+                                    INPUT_RNG2 | INPUT_NML, INPUT_OVFL};
+  struct sim_display display = {0U, rand() % (NUMBER_OF_DIGITS + 1),
+                                levels[rand() % 5]};
+  for (int i = 0; i < NUMBER_OF_DIGITS; ++i) {
+    display.digits = display.digits << 4U | (u32)(rand() % 10);
+  }
+  return display;
+}
+
+// Prints the reading that the display shows, as the decoder should.
+static char *print_display(char *buf, const struct sim_display *display) {
+  const int point = display->decimal_point;
+  u32 reading = display->digits;
+  if (point != 0) {
+    const unsigned below = 4U * (unsigned)(NUMBER_OF_DIGITS - point + 1);
+    const u32 low = reading & (((u32)1U << below) - 1U);
+    reading = (reading >> below) << (below + 4U) |
+              (u32)DECIMAL_POINT_BCD << below | low;
+  }
+  const unsigned levels = display->levels;
+  const enum unit unit = determine_unit(
+      (levels & INPUT_NML) != 0U, (levels & INPUT_RNG2) != 0U, point != 0);
+  return print_reading(buf, reading, point, (levels & INPUT_OVFL) != 0U, unit);
+}
+
+static struct sim sim_;
+static char expected_[NUM_GATES * MAX_READING_SIZE];
+static char text_[NUM_GATES * MAX_READING_SIZE];
+
+int main(void) {
+  srand(1900);
+  struct sim_display display = random_display();
+  char *end = expected_;
+  for (size_t i = 0U; i < NUM_GATES; ++i) {
+    const struct sim_display next = random_display();
+    sim_gate(&sim_, &display, &next, GATE_US);
+    end = print_display(end, &next);
+    display = next;
+  }
+  sim_scan(&sim_, &display, INPUT_nMUP);
+
+  struct timespec start;
+  timespec_get(&start, TIME_UTC);
+  size_t num_readings = 0U;
+  for (size_t pass = 0U; pass < NUM_PASSES; ++pass) {
+    num_readings += sim_capture(&sim_, false, text_);
+  }
+  const double elapsed = seconds_since(&start);
+  const double num_steps = (double)sim_.length * NUM_PASSES;
+  printf("capture: %zu readings in %.3f s, %.1f ns/step, %.0f ns/reading\n",
+         num_readings, elapsed, elapsed / num_steps * 1e9,
+         elapsed / (double)num_readings * 1e9);
+  if (num_readings != (size_t)NUM_GATES * NUM_PASSES ||
+      strcmp(expected_, text_) != 0) {
+    printf("readings differ\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+// Checks `decode()` of the 1900A against its reference model, so that the
+// firmware's decoder can be optimized without changing what it decodes.
+
+#include "1900a_sim.c"
+#include "equivalence.c"
+
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// The decoder as it was before any optimization. Keep it readable and do not
+// change it, unless the intended behaviour changes.
+static struct decoder_state
+reference_decode(const struct decoder_state state, const unsigned input) {
+  static const unsigned strobes[NUMBER_OF_DIGITS + 1] = {
+      0U, INPUT_AS6, INPUT_AS5, INPUT_AS4, INPUT_AS3, INPUT_AS2, INPUT_AS1};
+  const bool updating = (input & INPUT_nMUP) == 0U;
+  const int next = state.next_digit;
+  if (next == UPDATE_END) {
+    return updating ? state : (struct decoder_state){0U, 0, 0};
+  }
+  if (next < 1 || next > NUMBER_OF_DIGITS) {
+    return updating ? (struct decoder_state){0U, 1, 0} : state;
+  }
+  if (!updating) {
+    return (struct decoder_state){0U, 0, 0};
+  }
+  if ((input & strobes[next]) == 0U) {
+    return state;
+  }
+  if ((input & INPUT_DS) == 0U) {
+    return (struct decoder_state){state.reading << 4U | DCBA(input), next + 1,
+                                  state.decimal_point_digit};
+  }
+  const u32 point = DECIMAL_POINT_BCD;
+  return (struct decoder_state){
+      (state.reading << 4U | point) << 4U | DCBA(input), next + 1, next};
+}
+
+static struct decoder_state reference_;
+static struct decoder_state optimized_;
+
+static void reset(void) {
+  reference_ = (struct decoder_state){0U, 0, 0};
+  optimized_ = (struct decoder_state){0U, 0, 0};
+}
+
+// Compares what the firmware gets to see: whether a reading is complete, and
+// if so, the reading and its decimal point.
+static bool step(const unsigned input) {
+  reference_ = reference_decode(reference_, input);
+  optimized_ = decode(optimized_, input);
+  const bool complete = reference_.next_digit > NUMBER_OF_DIGITS;
+  if (complete != (optimized_.next_digit > NUMBER_OF_DIGITS)) {
+    return false;
+  }
+  if (complete) {
+    if (reference_.reading != optimized_.reading ||
+        reference_.decimal_point_digit != optimized_.decimal_point_digit) {
+      return false;
+    }
+    reference_ = (struct decoder_state){0U, UPDATE_END, 0};
+    optimized_ = (struct decoder_state){0U, UPDATE_END, 0};
+  }
+  return true;
+}
+
+static const struct equivalence equivalence_ = {reset, step};
+
+// all inputs but the unused bit 14
+#define ALL_INPUTS 0xbfffU
+
+void test_strobe_sequences(void) {
+  // long enough for a reading and the end of its memory update
+  static const unsigned alphabet[] = {
+      INPUT_nMUP | INPUT_AS6,      INPUT_AS6 | INPUT_A,
+      INPUT_AS5 | INPUT_DS,        INPUT_AS4 | INPUT_B,
+      INPUT_AS3 | INPUT_C,         INPUT_AS2 | INPUT_D | INPUT_DS,
+      INPUT_AS1 | INPUT_A | INPUT_D,
+  };
+  if (!check_exhaustive(&equivalence_, alphabet,
+                        sizeof alphabet / sizeof alphabet[0], 8U)) {
+    TEST_FAIL_MESSAGE(equivalence_failure_);
+  }
+}
+
+static unsigned stream_[1U << 20U];
+
+void test_random_stream(void) {
+  srand(1900);
+  random_stream(stream_, sizeof stream_ / sizeof stream_[0], ALL_INPUTS);
+  if (!check_stream(&equivalence_, stream_,
+                    sizeof stream_ / sizeof stream_[0])) {
+    TEST_FAIL_MESSAGE(equivalence_failure_);
+  }
+}
+
+static struct sim sim_;
+
+void test_fuzzed_stream(void) {
+  // updates of random displays, with bits flipped here and there
+  srand(1901);
+  for (int pass = 0; pass < 16; ++pass) {
+    sim_.length = 0U;
+    struct sim_display display = {0U, 0, 0U};
+    for (int i = 0; i < 256; ++i) {
+      const unsigned levels = INPUT_RNG2 | INPUT_NML | INPUT_OVFL;
+      const struct sim_display next = {(u32)rand() & 0x999999U,
+                                       rand() % (NUMBER_OF_DIGITS + 1),
+                                       (unsigned)rand() & levels};
+      sim_gate(&sim_, &display, &next, 10000U);
+      display = next;
+    }
+    size_t length = 0U;
+    for (size_t i = 0U; i < sim_.length && length < 1U << 20U; ++i) {
+      stream_[length++] = sim_.steps[i].input;
+    }
+    fuzz_stream(stream_, length, ALL_INPUTS, 20);
+    if (!check_stream(&equivalence_, stream_, length)) {
+      TEST_FAIL_MESSAGE(equivalence_failure_);
+    }
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_strobe_sequences);
+  RUN_TEST(test_random_stream);
+  RUN_TEST(test_fuzzed_stream);
+  return UNITY_END();
+}
@@ -1,48 +1,289 @@
 // MSP430G2452-based firmware for the 1900A DOU.
+//
+// Built with `USCI_UART=1`, it runs on a G2x53 instead, which sends the
+// readings through the UART of its USCI_A0 on the same pin, see
+// `on_usci_tx()`, rather than bit-banging them.
+//
+// With `READING_LOG` > 0, a reading every `LOG_INTERVAL` ms is also kept in a
+// log in as many segments of main flash, see `log_append()`. There is no pin
+// left to receive a request, so the host asks for the log by a reset from the
+// RST pin, e.g. through the DTR line of its USB-serial adapter, see
+// `log_upload()`, and acknowledges it by another one within `LOG_ACK_TIME` ms,
+// see `struct log_ack`.
 
-#include "1900a.c"
+#ifndef USCI_UART
+#define USCI_UART 0
+#endif
+#ifndef READING_LOG
+#define READING_LOG 0
+#endif
+#ifndef LOG_INTERVAL
+#define LOG_INTERVAL 60000 // ms
+#endif
+#ifndef LOG_ACK_TIME
+#define LOG_ACK_TIME 2000 // ms
+#endif
+
+#include "1900a_ports.c"
+#if USCI_UART
+#include "msp430/g2553.c"
+#else
 #include "msp430/g2452.c"
+#endif
 
-// Masks for the I/O ports.
-enum port1 {     // pin  | function
-  OUT_B = 0x01U, // P1.0 | BCD 2
-  AS_1 = 0x02U,  // P1.1 | LSD strobe
-  Tx = 0x04U,    // P1.2 | serial data out
-  RNG_2 = 0x08U, // P1.3 | range 2
-  NML = 0x10U,   // P1.4 |
-  OVFL = 0x20U,  // P1.5 | overflow indication
-  AS_3 = 0x40U,  // P1.6 | 4SD strobe
-  AS_2 = 0x80U,  // P1.7 | 5SD strobe
-};
-enum port2 {     // pin  | function
-  nMUP = 0x01U,  // P2.0 | memory update
-  OUT_C = 0x02U, // P2.1 | BCD 4
-  OUT_D = 0x04U, // P2.2 | BCD 8
-  AS_6 = 0x08U,  // P2.3 | MSD strobe
-  AS_5 = 0x10U,  // P2.4 | 2SD strobe
-  AS_4 = 0x20U,  // P2.5 | 3SD strobe
-  OUT_A = 0x40U, // P2.6 | BCD 1
-  DS = 0x80U     // P2.7 | decimal point strobe
+// The edges of the strobes and nMUP, as latched by `on_strobe()`, for the
+// decoder, so that none is lost while `main()` is busy. Both are `INPUT_*`
+// words: the pins that fired, and the ports right after.
+struct pending_edge {
+  unsigned fired;
+  unsigned input;
 };
+#define PENDING_EDGES 8U // a power of two
+static volatile struct pending_edge pending_[PENDING_EDGES];
+static volatile u8 pending_head_; // written by `on_strobe()`
+static volatile u8 pending_tail_; // written by `main()`
+static volatile u8 pending_lost_; // as the queue was full
 
+// Waits for the next edge, if none is pending, and returns the input of the
+// decoder for it: the strobes that fired are high and nMUP is low, if it fell,
+// even if they have changed again by the time the ports were read.
 static unsigned capture_input(void) {
-  const u8 port1 = P1IN;
-  const u8 port2 = P2IN;
-  return (port2 & OUT_A ? INPUT_A : 0U) | (port1 & OUT_B ? INPUT_B : 0U) |
-         (port2 & OUT_C ? INPUT_C : 0U) | (port2 & OUT_D ? INPUT_D : 0U) |
-         (port2 & AS_6 ? INPUT_AS6 : 0U) | (port2 & AS_5 ? INPUT_AS5 : 0U) |
-         (port2 & AS_4 ? INPUT_AS4 : 0U) | (port1 & AS_3 ? INPUT_AS3 : 0U) |
-         (port1 & AS_2 ? INPUT_AS2 : 0U) | (port1 & AS_1 ? INPUT_AS1 : 0U) |
-         (port1 & RNG_2 ? INPUT_RNG2 : 0U) | (port1 & NML ? INPUT_NML : 0U) |
-         (port1 & OVFL ? INPUT_OVFL : 0U) | (port1 & nMUP ? INPUT_nMUP : 0U) |
-         (port1 & DS ? INPUT_DS : 0U);
+  sleep_while(pending_head_ == pending_tail_);
+  const volatile struct pending_edge *e =
+      &pending_[pending_tail_ % PENDING_EDGES];
+  const unsigned input =
+      (e->input & ~e->fired) | (e->fired & ~(unsigned)INPUT_nMUP);
+  pending_tail_ = (u8)(pending_tail_ + 1U);
+  return input;
+}
+
+// The clocks, as configured by `main()`.
+#define SMCLK_FREQUENCY (16000000UL)
+#define ACLK_FREQUENCY  (1500UL) // VLOCLK / 8, nominal
+
+// The timing of the serial line at each of the `SERIAL_BAUD_RATES`.
+#if USCI_UART
+#define UCA0_BR_ENTRY(rate) UCA0_BR(SMCLK_FREQUENCY, (rate)),
+static const u16 uca0_br_[NUM_BAUD_RATES] = {SERIAL_BAUD_RATES(UCA0_BR_ENTRY)};
+#define UCA0_MCTL_ENTRY(rate) UCA0_MCTL(SMCLK_FREQUENCY, (rate)),
+static const u8 uca0_mctl_[NUM_BAUD_RATES] = {
+    SERIAL_BAUD_RATES(UCA0_MCTL_ENTRY)};
+#else
+#define BIT_TICKS(rate) (SMCLK_FREQUENCY / (rate) - 1U),
+static const u16 bit_ticks_[NUM_BAUD_RATES] = {SERIAL_BAUD_RATES(BIT_TICKS)};
+#define ACLK_CHAR_TICKS(rate) SERIAL_CHAR_TICKS(ACLK_FREQUENCY, (rate)),
+static const u8 aclk_char_ticks_[NUM_BAUD_RATES] = {
+    SERIAL_BAUD_RATES(ACLK_CHAR_TICKS)};
+#endif
+_Static_assert(DEADLINE_TICKS == ACLK_FREQUENCY / 10U, "ACLK mismatch");
+
+static u32 send_serial(const char *msg, u8 baud_rate);
+static void wait_sent(void);
+
+// The count of the timer when it was last added to the timestamp. The timer is
+// not cleared for that, which would lose the partial tick of ACLK, but the
+// bit-banged output starts it over, see `send_serial()`.
+static u16 timer_count_;
+
+NOINIT static struct retained retained_;
+INFO static const volatile struct config stored_config_;
+
+#if READING_LOG > 0
+// The log is a ring of flash segments, each with a header and as many records
+// as fit. Once the newest segment is full, the oldest one is erased and takes
+// the next records, so the segments wear evenly. A record is committed by its
+// last word, the upper half of the reading, which is never all ones, see
+// `pack_reading()`. Segments that were uploaded and acknowledged are no longer
+// in use, see `log_mark_uploaded()`.
+#define LOG_MAGIC          (0x1d09U)
+#define LOG_RECORDS        63U
+#define LOG_INTERVAL_TICKS ((u32)(LOG_INTERVAL * ACLK_FREQUENCY / 1000UL))
+#define LOG_ACK_TICKS      ((u32)(LOG_ACK_TIME * ACLK_FREQUENCY / 1000UL))
+
+struct log_segment {
+  u16 magic;      // `LOG_MAGIC`, once the segment is in use
+  u16 generation; // that of the previous segment plus one
+  u16 reserved[2];
+  u16 records[LOG_RECORDS][4]; // timestamp and reading, low half first
+};
+_Static_assert(sizeof(struct log_segment) == 512U, "not a flash segment");
+
+FLASH_LOG static volatile struct log_segment log_[READING_LOG];
+
+// Where the next record goes.
+struct log_position {
+  u8 segment;
+  u8 record;
+};
+
+// The upload that awaits the acknowledgement of the host, which is another
+// reset from the RST pin before the first reading `LOG_ACK_TIME` ms after the
+// end of the upload. Like `struct retained`, it is kept in the `.noinit`
+// section, and trusted only if the check word matches. As the records after
+// the upload go into a segment of their own, it is enough to know the newest
+// segment that was uploaded.
+struct log_ack {
+  u16 generation; // of the newest segment uploaded
+  u16 check;
+};
+
+NOINIT static struct log_ack log_ack_;
+
+static u16 log_ack_check(const struct log_ack *a) {
+  return (u16)(0x5a5aU ^ a->generation);
 }
 
-static void send_serial(const char msg[static MAX_READING_SIZE]);
+static bool log_ack_valid(const struct log_ack *a) {
+  return a->check == log_ack_check(a);
+}
+
+static void log_ack_clear(struct log_ack *a) {
+  a->check = (u16)~log_ack_check(a);
+}
+
+static bool log_in_use(const unsigned segment) {
+  return log_[segment].magic == LOG_MAGIC;
+}
+
+static bool log_committed(const volatile u16 record[static 4]) {
+  return record[3] != 0xffffU;
+}
+
+// Finds the end of the log, i.e. the newest segment in use, which is not
+// followed by the next generation, and the record after the last written one.
+// A record that was not committed is skipped.
+static struct log_position log_open(void) {
+  for (unsigned s = 0U; s < READING_LOG; ++s) {
+    const unsigned next = (s + 1U) % READING_LOG;
+    if (log_in_use(s) &&
+        !(log_in_use(next) &&
+          log_[next].generation == (u16)(log_[s].generation + 1U))) {
+      unsigned r = LOG_RECORDS;
+      for (; r > 0U; --r) {
+        const volatile u16 *record = log_[s].records[r - 1U];
+        if ((record[0] & record[1] & record[2] & record[3]) != 0xffffU) {
+          break;
+        }
+      }
+      return (struct log_position){(u8)s, (u8)r};
+    }
+  }
+  // none in use, so the first record starts a segment
+  return (struct log_position){READING_LOG - 1U, LOG_RECORDS};
+}
+
+// Appends a record of the packed reading, see `pack_reading()`, and its
+// timestamp. The CPU stalls for the writes, and the erase of a segment.
+static void log_append(struct log_position *p, const u32 reading,
+                       const u32 timestamp) {
+  if (p->record == LOG_RECORDS) {
+    const u16 generation = (u16)(log_[p->segment].generation + 1U);
+    p->segment = (u8)((p->segment + 1U) % READING_LOG);
+    p->record = 0U;
+    volatile struct log_segment *segment = &log_[p->segment];
+    flash_erase(&segment->magic);
+    flash_write(&segment->generation, generation);
+    flash_write(&segment->magic, LOG_MAGIC);
+  }
+  volatile u16 *record = log_[p->segment].records[p->record];
+  flash_write(&record[0], (u16)timestamp);
+  flash_write(&record[1], (u16)(timestamp >> 16U));
+  flash_write(&record[2], (u16)reading);
+  flash_write(&record[3], (u16)(reading >> 16U));
+  p->record = (u8)(p->record + 1U);
+}
+
+// Sends the committed records of the log, oldest first, as burst frames of the
+// most readings each, after `#L <records>\r\n`, see `burst_add()`. Their
+// sequence is the index in the log. A frame ends early at a reset, where the
+// timestamps start over. Returns the ACLK ticks that the timer did not count,
+// see `send_serial()`.
+static u32 log_upload(char text[static MAX_OUTPUT_SIZE],
+                      char report[static MAX_REPORT_SIZE],
+                      const struct log_position *p, const u8 baud_rate) {
+  u16 count = 0U;
+  for (unsigned i = 1U; i <= READING_LOG; ++i) {
+    const unsigned s = (p->segment + i) % READING_LOG;
+    for (unsigned r = 0U; log_in_use(s) && r < LOG_RECORDS; ++r) {
+      if (log_committed(log_[s].records[r])) {
+        count = (u16)(count + 1U);
+      }
+    }
+  }
+  if (count == 0U) {
+    return 0U;
+  }
+  const char *end = &report[MAX_REPORT_SIZE - 1];
+  char *dst = print_str(report, end, "#L ");
+  dst = print_uint(dst, end, count);
+  dst = print_str(dst, end, "\r\n");
+  *dst = '\0';
+  u32 ticks = send_serial(report, baud_rate);
+
+  struct burst burst = {0U, 0U, 0U, 0U, 0U};
+  u16 sequence = 0U;
+  u32 previous = 0U;
+  for (unsigned i = 1U; i <= READING_LOG; ++i) {
+    const unsigned s = (p->segment + i) % READING_LOG;
+    for (unsigned r = 0U; log_in_use(s) && r < LOG_RECORDS; ++r) {
+      const volatile u16 *record = log_[s].records[r];
+      if (!log_committed(record)) {
+        continue;
+      }
+      const u32 timestamp = (u32)record[1] << 16U | record[0];
+      wait_sent(); // the frame is built in `text`
+      if (burst.count > 0U && timestamp < previous) {
+        burst_finish(text, &burst);
+        ticks += send_serial(text, baud_rate);
+        wait_sent();
+      }
+      previous = timestamp;
+      if (burst_add(text, &burst, (u32)record[3] << 16U | record[2],
+                    sequence, timestamp, BURST_SIZE, 0U)) {
+        ticks += send_serial(text, baud_rate);
+        WDTCTL = WDT_UNLOCK | WDT_CLEAR | WDT_ACLK | WDT_32768;
+      }
+      sequence = (u16)(sequence + 1U);
+    }
+  }
+  if (burst.count > 0U) {
+    wait_sent();
+    burst_finish(text, &burst);
+    ticks += send_serial(text, baud_rate);
+  }
+  return ticks;
+}
+
+// Takes the segments up to the given generation out of it by clearing their
+// magic, which needs no erase, so that the next upload does not repeat their
+// records. Returns the end of the log with the remaining ones.
+static struct log_position log_mark_uploaded(const u16 generation) {
+  for (unsigned s = 0U; s < READING_LOG; ++s) {
+    if (log_in_use(s) && (i16)(log_[s].generation - generation) <= 0) {
+      flash_write(&log_[s].magic, 0U);
+    }
+  }
+  return log_open();
+}
+#endif
 
 int main(void) {
   WDTCTL = WDT_UNLOCK | WDT_HOLD;
 
+  // After a watchdog reset, carry on with the retained state.
+  const bool warm_restart = (IFG1 & IFG1_WDT) && retained_valid(&retained_);
+#if READING_LOG > 0
+  // The host asks for the log by a reset from the RST pin.
+  const bool pin_reset = (IFG1 & IFG1_RST) != 0U;
+#endif
+  IFG1 = (u8)(IFG1 & ~(IFG1_WDT | IFG1_RST));
+  if (warm_restart) {
+    retained_.resets += 1U;
+  } else {
+    retained_ = (struct retained){0U, 0U, 0U};
+  }
+  retained_commit(&retained_);
+
   // Clear P2SEL reasonably early, because excess current will flow from
   // the oscillator driver output at P2.7.
   P2SEL = 0U;
@@ -52,12 +293,17 @@ int main(void) {
   // calibration for 16 MHz. So if one of those is to be used, the constants
   // have to be determined by hand. The `msp430/info_util.c` can be used to
   // store the constants to the info memory.
-  BCSCTL1 = CAL_BC1_16MHz;
+  // ACLK is divided by 8 to get a watchdog interval beyond the longest gate
+  // time.
+  BCSCTL1 = CAL_BC1_16MHz | BCSCTL1_DIVA_8;
   DCOCTL = CAL_DCO_16MHz;
-#define SMCLK_FREQUENCY (16000000UL)
   BCSCTL3 = 0x24U; // ACLK = VLOCLK
 
-  TACTL = TACTL_SMCLK; // use SMCLK for best resolution of serial baudrate
+  // The timer counts ACLK for the restart time and the timestamps, also while
+  // the flash stalls the CPU, but not while it clocks the bit-banged output,
+  // see `send_serial()`.
+  TACTL = TACTL_ACLK | TACTL_CLEAR | TACTL_CONTINUOUS;
+  timer_count_ = 0U;
 
   P1OUT = Tx;
   P1DIR = Tx;
@@ -71,20 +317,77 @@ int main(void) {
 
   enable_interrupts();
 
-  for (;;) {
+  // The watchdog timer will reset the device, if no nMUP signal has been
+  // detected after expiration of the longest gate time of 10 seconds.
+  // ACLK = VLOCLK / 8 = max. 2,5 kHz, according to datasheet
+  // 2,5 kHz / 32768 = ~13 s
+  WDTCTL = WDT_UNLOCK | WDT_CLEAR | WDT_ACLK | WDT_32768;
+
+  // There is no pin left to receive commands, so the configuration can only
+  // be changed in the information memory, and the readings are always sent.
+  const struct config config = config_load(&stored_config_);
+#if USCI_UART
+  // 7N1 on P1.2, as when bit-banged
+  UCA0CTL1 = UCSSEL_SMCLK | UCSWRST;
+  UCA0CTL0 = UC7BIT;
+  UCA0BR0 = (u8)uca0_br_[config.baud_rate];
+  UCA0BR1 = (u8)(uca0_br_[config.baud_rate] >> 8U);
+  UCA0MCTL = uca0_mctl_[config.baud_rate];
+  P1SEL |= Tx;
+  P1SEL2 |= Tx;
+  UCA0CTL1 = UCSSEL_SMCLK;
+#endif
+  struct si_average average = {0, 0U, false, {0, 0, SI_NONE}};
+  // a burst frame is built up over several readings
+  struct burst burst = {0U, 0U, 0U, 0U, 0U};
+  char text[MAX_OUTPUT_SIZE];
+  char report[MAX_REPORT_SIZE];
+  // since the reset in ACLK ticks
+  u32 timestamp = 0U;
+#if READING_LOG > 0
+  // flash timing generator operation frequency must be in 257..476 kHz
+  FCTL2 = FLASH_KEY | FCTL2_SMCLK | FCTL2_DIVIDE_BY(40);
+  struct log_position log = log_open();
+  if (pin_reset && log_ack_valid(&log_ack_)) {
+    log = log_mark_uploaded(log_ack_.generation);
+    log_ack_clear(&log_ack_);
+  } else if (pin_reset) {
+    timestamp += log_upload(text, report, &log, config.baud_rate);
+    wait_sent();
+    if (log_in_use(log.segment)) {
+      log_ack_.generation = log_[log.segment].generation;
+      log_ack_.check = log_ack_check(&log_ack_);
+      log.record = LOG_RECORDS;
+    }
+  } else {
+    log_ack_clear(&log_ack_);
+  }
+  u32 log_due = timestamp; // of the next record
+  // of the acknowledgement of the upload, if any
+  const u32 ack_due = timestamp + LOG_ACK_TICKS;
+#endif
+  struct decoder_state state = {0U, 0, 0};
+  for (bool first_reading = true;; first_reading = false) {
     P1IE = AS_3 | AS_2 | AS_1;
     P2IE = AS_6 | AS_5 | AS_4 | nMUP;
-    struct decoder_state state = {0U, 0, 0};
-    for (; state.next_digit <= NUMBER_OF_DIGITS;
-         state = decode(state, capture_input())) {
-      // The watchdog timer will reset the device, if no nMUP signal has been
-      // detected after expiration of the longest gate time of 10 seconds.
-      // TODO set up watchdog
-      go_to_sleep();
+    const bool lock_on = LOCK_ON_START && first_reading;
+    while (state.next_digit <= NUMBER_OF_DIGITS) {
+      const unsigned input = capture_input();
+      state = decode(state, lock_on ? HELD_INPUT(input) : input);
     }
     P1IE = 0U;
     P2IE = 0U;
 
+    // serviced once per reading, i.e. once per gate time
+    WDTCTL = WDT_UNLOCK | WDT_CLEAR | WDT_ACLK | WDT_32768;
+
+    // The watchdog resets the device long before the timer overflows.
+    const u16 count = TAR;
+    const u16 ticks = (u16)(count - timer_count_);
+    timer_count_ = count;
+    timestamp += ticks;
+    const u32 reading_time = timestamp;
+
     // Only complete readings are returned. This prevents erroneous readings,
     // which can occur due to glitches that appear on the bus when actuating
     // the front panel switches.
@@ -95,59 +398,167 @@ int main(void) {
     enum unit unit = determine_unit(port1 & NML, port1 & RNG_2,
                                     state.decimal_point_digit != 0);
 
-    char text[MAX_READING_SIZE];
-    print_reading(text, state.reading, state.decimal_point_digit, overflow,
-                  unit);
+    wait_sent(); // the previous reading may still be on its way
+    if (print_output(text, &config, &average, &burst, state.reading,
+                     state.decimal_point_digit, overflow, unit,
+                     retained_.sequence, reading_time)) {
+      timestamp += send_serial(text, config.baud_rate);
+      retained_.sequence += 1U;
+      retained_commit(&retained_);
+    }
+
+    if (first_reading && (warm_restart || STARTUP_REPORT)) {
+      // the timestamp, so that the time of the log upload counts in both
+      // builds, measured or estimated as the timestamps are
+      print_restart_report(report, warm_restart, retained_.resets,
+                           reading_time);
+      timestamp += send_serial(report, config.baud_rate);
+    }
 
-    send_serial(text);
+#if READING_LOG > 0
+    // after sending, which may start the timer over, so that it counts the
+    // time the flash takes
+    if ((i32)(reading_time - log_due) >= 0) {
+      log_append(&log, pack_reading(state.reading, overflow, unit),
+                 reading_time);
+      log_due = reading_time + LOG_INTERVAL_TICKS;
+    }
+    if ((i32)(reading_time - ack_due) >= 0) {
+      log_ack_clear(&log_ack_); // the host did not acknowledge the upload
+    }
+#endif
 
-    // TODO The decoder allows multiple passes (MSD..LSD) and always updates the
-    //  reading with the digits from the latest pass.
+    state = (struct decoder_state){0U, UPDATE_END, 0};
   }
 }
 
-static void send_serial(const char msg[static MAX_READING_SIZE]) {
-  // start timer for serial data clock
-  TACCR0 = (SMCLK_FREQUENCY / SERIAL_BAUD_RATE) - 1;
-  TACTL_START(TACTL_UP);
+#if USCI_UART
+// The message that is being sent by `on_usci_tx()`, if any.
+static const char *volatile sending_;
+static u8 frame_check_; // CRC-8 of the message so far
+static u8 trailer_;     // number of frame check characters sent
+
+static void wait_sent(void) { sleep_while(sending_ != nullptr); }
 
-  // configure serial output
-  P1SEL |= Tx; // USI on P1.6
-  USICCTL = USI_TACCR0;
-  USICTL = USI_PE6 | USI_LSB | USI_MASTER | USI_OE;
-  // spurious interrupt can be triggered, if USIIE is set in reset
-  while (USICTL & USI_RESET) {
+// Starts sending the message in the background, once the previous one is out.
+// Returns 0, as the timer keeps counting meanwhile.
+static u32 send_serial(const char *msg, const u8 baud_rate) {
+  (void)baud_rate; // as set up by `main()`
+  wait_sent();
+  if (*msg != '\0') {
+    sending_ = msg;
+    frame_check_ = 0U;
+    trailer_ = 0U;
+    IE2 |= UCA0TXIE; // the transmit buffer is empty, so it starts right away
   }
-  USICTL |= USI_IE;
+  return 0U;
+}
 
-  for (int i = 0; i < MAX_READING_SIZE && msg[i] != '\0'; ++i) {
-    //       make space for the start bit --vv
-    unsigned character = STOP_BIT | ((unsigned)msg[i] << 1U);
-    //         extra start & stop bits --v
-    for (int bit = 0; bit < SERIAL_DATA_BITS + 2; ++bit) {
-      go_to_sleep();
-      P1OUT = (u8)((unsigned)(P1OUT & ~Tx) | (character & 1U ? Tx : 0U));
-      character >>= 1U;
+// Puts the next character of the message, including the frame check, if
+// enabled, into the transmit buffer, while the previous one is being shifted
+// out. Wakes up `wait_sent()` at the end of the message.
+__attribute__((interrupt)) void on_usci_tx(void) {
+  const char c = *sending_;
+  if (SERIAL_FRAME_CHECK && c == '\r' && trailer_ < FRAME_CHECK_SIZE) {
+    UCA0TXBUF = (u8)(trailer_ == 0U   ? FRAME_CHECK_MARKER
+                     : trailer_ == 1U ? hex_digit(frame_check_ >> 4U)
+                                      : hex_digit(frame_check_));
+    trailer_ += 1U;
+    return;
+  }
+  if (c == '\0') {
+    IE2 = (u8)(IE2 & ~UCA0TXIE);
+    sending_ = nullptr;
+    // not while decoding, which would take the wakeup for an edge
+    if ((P1IE | P2IE) == 0U) {
+      stay_awake();
     }
+    return;
+  }
+  UCA0TXBUF = (u8)c;
+  frame_check_ = frame_check_update(frame_check_, c);
+  sending_ = sending_ + 1;
+}
+#else
+static void wait_sent(void) {}
+
+// Bit-bangs the given character, one bit per timer period.
+static void send_char(const char c) {
+  //       make space for the start bit --vv
+  unsigned character = STOP_BIT | ((unsigned)c << 1U);
+  //         extra start & stop bits --v
+  for (int bit = 0; bit < SERIAL_DATA_BITS + 2; ++bit) {
     go_to_sleep();
-    P1OUT = P1OUT | Tx;
+    P1OUT = (u8)((unsigned)(P1OUT & ~Tx) | (character & 1U ? Tx : 0U));
+    character >>= 1U;
   }
+  go_to_sleep();
+  P1OUT = P1OUT | Tx;
+}
+
+// Tx stays a GPIO, as the USI cannot drive P1.2, and `on_timer()` wakes up
+// `send_char()` for each bit. Returns the ACLK ticks estimated for the
+// characters sent, as the timer clocks them rather than counting ACLK, which
+// it starts over with afterwards, see `timer_count_`.
+static u32 send_serial(const char *msg, const u8 baud_rate) {
+  // start timer for serial data clock, without the flag that CCR0 may have
+  // set while the timer was counting ACLK
+  TACCR0 = bit_ticks_[baud_rate];
+  TACCTL0 = TACCTL0_CCIE;
+  TACTL = TACTL_SMCLK | TACTL_CLEAR | TACTL_UP;
 
-  TACTL_STOP();
+  unsigned num_sent = 0U;
+  u8 crc = 0U;
+  for (; *msg != '\0'; ++msg, ++num_sent) {
+    if (SERIAL_FRAME_CHECK && *msg == '\r') {
+      num_sent += FRAME_CHECK_SIZE;
+      send_char(FRAME_CHECK_MARKER);
+      send_char(hex_digit(crc >> 4U));
+      send_char(hex_digit(crc));
+    }
+    // the checksum is updated while the stop bit is being sent
+    crc = frame_check_update(crc, *msg);
+    send_char(*msg);
+  }
+
+  TACCTL0 = 0U;
+  TACTL = TACTL_ACLK | TACTL_CLEAR | TACTL_CONTINUOUS;
+  timer_count_ = 0U;
+  return num_sent * aclk_char_ticks_[baud_rate];
 }
+#endif
 
+// Latches the edges that fired, with the ports, for `capture_input()`. Only
+// their flags are cleared, each by a single BIC, so that an edge that comes
+// meanwhile calls the ISR again rather than being lost.
 __attribute__((interrupt)) void on_strobe() {
-  P1IFG = 0U;
-  P2IFG = 0U;
+  const u8 fired1 = P1IFG & P1IE;
+  P1IFG = (u8)(P1IFG & ~fired1);
+  const u8 fired2 = P2IFG & P2IE;
+  P2IFG = (u8)(P2IFG & ~fired2);
+  if ((u8)(pending_head_ - pending_tail_) == PENDING_EDGES) {
+    pending_lost_ = (u8)(pending_lost_ + 1U);
+  } else {
+    volatile struct pending_edge *e = &pending_[pending_head_ % PENDING_EDGES];
+    e->fired = remap_ports(fired1, fired2);
+    e->input = remap_ports(P1IN, P2IN);
+    pending_head_ = (u8)(pending_head_ + 1U);
+  }
   stay_awake();
 }
 
+#if !USCI_UART
 __attribute__((interrupt)) void on_timer() {
   stay_awake();
 }
+#endif
 
 __attribute__((used, section(".vectors"))) static const struct vtable vt = {
     .reset = on_reset,
     .port1 = on_strobe,
     .port2 = on_strobe,
+#if USCI_UART
+    .usci_tx = on_usci_tx};
+#else
     .timer0_a3 = on_timer};
+#endif
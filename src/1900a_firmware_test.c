@@ -0,0 +1,238 @@
+// Runs the 1900A firmware on the simulated MCU, see `msp430/mcu_sim.c`, with
+// the simulated bus, and checks what it sends, including the log of readings
+// on request. It is built for a G2x53, which sends through the UART of the
+// USCI, and with `USCI_UART=0` for a G2452, which bit-bangs.
+
+#define MSP430_SIM
+#ifndef USCI_UART
+#define USCI_UART 1
+#endif
+#define SERIAL_BAUD_RATE 115200
+#define READING_LOG      2
+#define LOG_INTERVAL     50 // ms, more than a gate time of 10 ms, less than 100
+#define LOG_ACK_TIME     1000 // ms, more than 3 gate times of 100 ms
+
+#include "1900a_firmware.c"
+#include "1900a_sim.c"
+
+#undef main
+
+#include <unity.h>
+
+#include "host/burst.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+// as after programming the firmware
+void setUp(void) {
+  memset((void *)log_, 0xff, sizeof log_);
+}
+void tearDown(void) {}
+
+static const struct mcu_board board_ = {&vt, Tx, SERIAL_BAUD_RATE, 0U, 0U};
+
+static struct sim sim_;
+static struct mcu_edge edges_[SIM_MAX_STEPS];
+
+static const struct sim_display displays_[] = {
+    {0x001234U, 4, INPUT_RNG2},             // 001.234 MHz
+    {0x123456U, 6, 0U},                     // 12345.6 ms
+    {0x000001U, 1, INPUT_NML},              // .000001 us
+    {0x123456U, 5, INPUT_RNG2 | INPUT_NML}, // 1234.56 kHz
+};
+
+// The reading on display at the start comes first, see `LOCK_ON_START`.
+#define SIMULATED_READINGS                                                     \
+  " 001.234MHz\r\n 12345.6ms\r\n .000001us\r\n 1234.56kHz\r\n"
+
+// Simulates the given number of gate times, starting with the first of the
+// `displays_` and going through them in turn, with each digit scanned at the
+// given pace, see `struct sim`.
+static size_t simulate(const size_t gates, const u32 gate_us,
+                       const u32 pace_us) {
+  sim_.length = 0U;
+  sim_.pace_us = pace_us;
+  for (size_t i = 0U; i < gates; ++i) {
+    sim_gate(&sim_, &displays_[i % 4U], &displays_[(i + 1U) % 4U], gate_us);
+  }
+  // long enough to send the last reading
+  for (u32 t = 0U; t < SIM_SCAN_US; t += sim_scan_us(&sim_)) {
+    sim_scan(&sim_, &displays_[gates % 4U], INPUT_nMUP);
+  }
+  return sim_edges(&sim_, edges_);
+}
+
+void test_readings(void) {
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board_, edges_, simulate(3U, 100000U, 0U)));
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, mcu_.output);
+#if USCI_UART
+  // one interrupt per character, and one at the end of each reading, which
+  // are sent while the decoder waits for the next one
+  TEST_ASSERT_EQUAL_UINT32(strlen(SIMULATED_READINGS) + 4U,
+                           mcu_.serviced[MCU_USCI_TX]);
+  TEST_ASSERT_EQUAL_UINT32(mcu_.serviced[MCU_PORT1] +
+                               mcu_.serviced[MCU_PORT2],
+                           mcu_.wakeups);
+#else
+  // one interrupt per bit and one for the stop bit to end, start & stop bits
+  // included
+  TEST_ASSERT_EQUAL_UINT32(strlen(SIMULATED_READINGS) *
+                               (SERIAL_DATA_BITS + 3U),
+                           mcu_.serviced[MCU_TIMER]);
+  TEST_ASSERT_EQUAL_UINT32(mcu_.serviced[MCU_PORT1] +
+                               mcu_.serviced[MCU_PORT2] +
+                               mcu_.serviced[MCU_TIMER],
+                           mcu_.wakeups);
+#endif
+}
+
+void test_closely_spaced_edges(void) {
+  // The strobes come every 6 µs, each high for 2 µs, while `main()` reads the
+  // inputs only 5 µs after a wakeup, and the ISR is called meanwhile.
+  static const struct mcu_board board = {&vt, Tx, SERIAL_BAUD_RATE, 0U, 5U};
+  pending_lost_ = 0U;
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board, edges_, simulate(3U, 100000U, 2U)));
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, mcu_.output);
+  // the timer wakes up `send_char()` for each bit, if bit-banged
+  TEST_ASSERT_LESS_THAN_UINT32(mcu_.serviced[MCU_PORT1] +
+                                   mcu_.serviced[MCU_PORT2],
+                               mcu_.wakeups - mcu_.serviced[MCU_TIMER]);
+  TEST_ASSERT_EQUAL_UINT8(0U, pending_lost_);
+}
+
+// The packed words of the `displays_`, see `pack_reading()`.
+static const u32 packed_[] = {0x2001b234U, 0x012345b6U, 0x1b000001U,
+                              0x31234b56U};
+
+// Parses the upload of the log at the start of the output, see `log_upload()`.
+// Returns the number of records, the time from the first to the last one, and
+// the rest of the output.
+static size_t parse_upload(const char **output, u32 *readings, u32 *span) {
+  const char *src = *output;
+  TEST_ASSERT_EQUAL_STRING_LEN("#L ", src, 3U);
+  const size_t count = strtoul(src + 3, nullptr, 10);
+  src = strstr(src, "\r\n") + 2;
+  u32 first = 0U;
+  for (size_t n = 0U; n < count;) {
+    const char *end = strstr(src, "\r\n") + 2;
+    struct burst_frame frame;
+    TEST_ASSERT_TRUE(parse_burst(src, (size_t)(end - src), &frame));
+    TEST_ASSERT_EQUAL_UINT32(n, frame.sequence);
+    memcpy(&readings[n], frame.readings, frame.count * sizeof readings[0]);
+    if (n == 0U) {
+      first = frame.timestamp;
+    }
+    *span = frame.timestamp + frame.span - first;
+    n += frame.count;
+    src = end;
+  }
+  *output = src;
+  return count;
+}
+
+// Runs the firmware after a reset from the RST pin, by which the host asks for
+// the log, or acknowledges its upload.
+static enum mcu_exit run_after_pin_reset(const size_t num_edges) {
+  IFG1 |= IFG1_RST;
+  return mcu_run(&board_, edges_, num_edges);
+}
+
+void test_log_upload_on_request(void) {
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board_, edges_, simulate(3U, 100000U, 0U)));
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, mcu_.output);
+  // not after a power-on reset
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board_, edges_, simulate(3U, 100000U, 0U)));
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, mcu_.output);
+  // the readings of both runs before those of the third
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        run_after_pin_reset(simulate(3U, 100000U, 0U)));
+  const char *output = mcu_.output;
+  u32 readings[21];
+  u32 span;
+  TEST_ASSERT_EQUAL_size_t(8U, parse_upload(&output, readings, &span));
+  for (size_t i = 0U; i < 8U; ++i) {
+    TEST_ASSERT_EQUAL_HEX32(packed_[i % 4U], readings[i]);
+  }
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, output);
+  // the acknowledgement within `LOG_ACK_TIME`, which takes them out of the log
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        run_after_pin_reset(simulate(3U, 100000U, 0U)));
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, mcu_.output);
+  // only those of the third and fourth run, but not acknowledged in time
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        run_after_pin_reset(simulate(12U, 100000U, 0U)));
+  output = mcu_.output;
+  TEST_ASSERT_EQUAL_size_t(8U, parse_upload(&output, readings, &span));
+  // so the next request gets them again, with those of the fifth run
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        run_after_pin_reset(simulate(3U, 100000U, 0U)));
+  output = mcu_.output;
+  TEST_ASSERT_EQUAL_size_t(21U, parse_upload(&output, readings, &span));
+  for (size_t i = 0U; i < 21U; ++i) {
+    TEST_ASSERT_EQUAL_HEX32(packed_[i % 4U], readings[i]);
+  }
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, output);
+}
+
+void test_log_interval(void) {
+  // a reading every 14.4 ms, of which about every fourth is logged, the first
+  // one right away
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board_, edges_, simulate(31U, 10000U, 0U)));
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        run_after_pin_reset(simulate(3U, 100000U, 0U)));
+  const char *output = mcu_.output;
+  u32 readings[8];
+  u32 span;
+  TEST_ASSERT_EQUAL_size_t(8U, parse_upload(&output, readings, &span));
+  TEST_ASSERT_EQUAL_HEX32(packed_[0], readings[0]);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(7U * LOG_INTERVAL_TICKS, span);
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, output);
+}
+
+void test_log_wraps_around(void) {
+  // more readings than the log takes, 63 per segment
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board_, edges_, simulate(129U, 100000U, 0U)));
+  // one segment taken into use, and each erased once more, when it was the
+  // oldest one
+  TEST_ASSERT_EQUAL_UINT32(3U, mcu_.flash_erases);
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        run_after_pin_reset(simulate(3U, 100000U, 0U)));
+  // the 130 readings less the first 63, which were erased
+  const char *output = mcu_.output;
+  static u32 readings[READING_LOG * LOG_RECORDS];
+  u32 span;
+  TEST_ASSERT_EQUAL_size_t(130U - LOG_RECORDS,
+                           parse_upload(&output, readings, &span));
+  for (size_t i = 0U; i < 130U - LOG_RECORDS; ++i) {
+    TEST_ASSERT_EQUAL_HEX32(packed_[(LOG_RECORDS + i) % 4U], readings[i]);
+  }
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, output);
+#if USCI_UART
+  // The timer kept counting ACLK, also while the flash stalled the CPU for the
+  // erase of a segment, whereas the time of the bit-banged output is estimated.
+  const uint64_t gate_us =
+      ((100000U + SIM_SCAN_US - 1U) / SIM_SCAN_US + SIM_UPDATE_SCANS) *
+      SIM_SCAN_US;
+  TEST_ASSERT_UINT32_WITHIN(1U,
+                            (129U - LOG_RECORDS) * gate_us * MCU_TICKS_PER_US /
+                                mcu_clock_ticks(true),
+                            span);
+#endif
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings);
+  RUN_TEST(test_closely_spaced_edges);
+  RUN_TEST(test_log_upload_on_request);
+  RUN_TEST(test_log_interval);
+  RUN_TEST(test_log_wraps_around);
+  return UNITY_END();
+}
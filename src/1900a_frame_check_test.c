@@ -0,0 +1,98 @@
+// Runs the 1900A firmware with the frame check on the simulated MCU, see
+// `1900a_firmware_test.c`, and checks the trailer of each line it sends. It is
+// built for both ways of sending, through the USCI and, with `USCI_UART=0`,
+// bit-banged.
+
+#define MSP430_SIM
+#ifndef USCI_UART
+#define USCI_UART 1
+#endif
+#define SERIAL_BAUD_RATE   115200
+#define SERIAL_FRAME_CHECK 1
+#define READING_LOG        2
+#define LOG_INTERVAL       50 // ms, i.e. each reading
+
+#include "1900a_firmware.c"
+#include "1900a_sim.c"
+
+#undef main
+
+#include <unity.h>
+
+#include "host/frame_check.c"
+
+#include <string.h>
+
+// The reading on display at the start comes first, see `LOCK_ON_START`.
+#define SIMULATED_READINGS                                                     \
+  " 001.234MHz\r\n 12345.6ms\r\n 001.234MHz\r\n 12345.6ms\r\n"
+
+void setUp(void) {
+  memset((void *)log_, 0xff, sizeof log_);
+}
+void tearDown(void) {}
+
+static const struct mcu_board board_ = {&vt, Tx, SERIAL_BAUD_RATE, 0U, 0U};
+
+static struct sim sim_;
+static struct mcu_edge edges_[SIM_MAX_STEPS];
+
+static const struct sim_display displays_[] = {
+    {0x001234U, 4, INPUT_RNG2}, // 001.234 MHz
+    {0x123456U, 6, 0U},         // 12345.6 ms
+};
+
+// Simulates three gate times of 100 ms, which alternate between the
+// `displays_`, see `1900a_firmware_test.c`.
+static size_t simulate(void) {
+  sim_.length = 0U;
+  sim_.pace_us = 0U;
+  for (size_t i = 0U; i < 3U; ++i) {
+    sim_gate(&sim_, &displays_[i % 2U], &displays_[(i + 1U) % 2U], 100000U);
+  }
+  // long enough to send the last reading
+  for (u32 t = 0U; t < SIM_SCAN_US; t += sim_scan_us(&sim_)) {
+    sim_scan(&sim_, &displays_[1], INPUT_nMUP);
+  }
+  return sim_edges(&sim_, edges_);
+}
+
+// Checks and strips the trailer of each line of the output, in place.
+static void strip_output(void) {
+  char *line = mcu_.output;
+  char *stripped = mcu_.output;
+  for (char *end; (end = strstr(line, "\r\n")) != nullptr; line = end + 2) {
+    const size_t size = frame_check_strip(line, (size_t)(end + 2 - line));
+    TEST_ASSERT_NOT_EQUAL_size_t(0U, size);
+    memmove(stripped, line, size);
+    stripped += size;
+  }
+  TEST_ASSERT_EQUAL_STRING("", line);
+  *stripped = '\0';
+}
+
+void test_readings(void) {
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, simulate()));
+  strip_output();
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, mcu_.output);
+}
+
+void test_log_upload(void) {
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, simulate()));
+  IFG1 |= IFG1_RST; // the host asks for the log
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, simulate()));
+  // the header and the burst frames carry a trailer as well
+  strip_output();
+  TEST_ASSERT_EQUAL_STRING_LEN("#L 4\r\n", mcu_.output, 6U);
+  const size_t length = strlen(mcu_.output);
+  TEST_ASSERT_GREATER_THAN_size_t(strlen(SIMULATED_READINGS), length);
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS,
+                           &mcu_.output[length - strlen(SIMULATED_READINGS)]);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings);
+  RUN_TEST(test_log_upload);
+  return UNITY_END();
+}
@@ -0,0 +1,47 @@
+// Pin assignment of the 1900A DOU and the mapping of the port states to the
+// inputs of the decoder.
+
+#include "1900a.c"
+
+// Masks for the I/O ports.
+enum port1 {     // pin  | function
+  OUT_B = 0x01U, // P1.0 | BCD 2
+  AS_1 = 0x02U,  // P1.1 | LSD strobe
+  Tx = 0x04U,    // P1.2 | serial data out
+  RNG_2 = 0x08U, // P1.3 | range 2
+  NML = 0x10U,   // P1.4 |
+  OVFL = 0x20U,  // P1.5 | overflow indication
+  AS_3 = 0x40U,  // P1.6 | 4SD strobe
+  AS_2 = 0x80U,  // P1.7 | 5SD strobe
+};
+enum port2 {     // pin  | function
+  nMUP = 0x01U,  // P2.0 | memory update
+  OUT_C = 0x02U, // P2.1 | BCD 4
+  OUT_D = 0x04U, // P2.2 | BCD 8
+  AS_6 = 0x08U,  // P2.3 | MSD strobe
+  AS_5 = 0x10U,  // P2.4 | 2SD strobe
+  AS_4 = 0x20U,  // P2.5 | 3SD strobe
+  OUT_A = 0x40U, // P2.6 | BCD 1
+  DS = 0x80U     // P2.7 | decimal point strobe
+};
+
+#define PORT1_INPUTS(port1)                                                    \
+  (REMAP_PIN(port1, OUT_B, INPUT_B) | REMAP_PIN(port1, AS_1, INPUT_AS1) |      \
+   REMAP_PIN(port1, RNG_2, INPUT_RNG2) | REMAP_PIN(port1, NML, INPUT_NML) |    \
+   REMAP_PIN(port1, OVFL, INPUT_OVFL) | REMAP_PIN(port1, AS_3, INPUT_AS3) |    \
+   REMAP_PIN(port1, AS_2, INPUT_AS2))
+#define PORT2_INPUTS(port2)                                                    \
+  (REMAP_PIN(port2, nMUP, INPUT_nMUP) | REMAP_PIN(port2, OUT_C, INPUT_C) |     \
+   REMAP_PIN(port2, OUT_D, INPUT_D) | REMAP_PIN(port2, AS_6, INPUT_AS6) |      \
+   REMAP_PIN(port2, AS_5, INPUT_AS5) | REMAP_PIN(port2, AS_4, INPUT_AS4) |     \
+   REMAP_PIN(port2, OUT_A, INPUT_A) | REMAP_PIN(port2, DS, INPUT_DS))
+
+// The inputs for each state of the ports, generated at compile time. The pins
+// are scattered too much for a few shifts, and the MSP430 shifts by one bit per
+// instruction, so two lookups are the cheapest way to map them.
+static const u16 port1_inputs_[256] = {PORT_TABLE(PORT1_INPUTS)};
+static const u16 port2_inputs_[256] = {PORT_TABLE(PORT2_INPUTS)};
+
+static unsigned remap_ports(const u8 port1, const u8 port2) {
+  return (unsigned)port1_inputs_[port1] | port2_inputs_[port2];
+}
@@ -0,0 +1,144 @@
+// Simulates the signals of the 1900A bus as seen by the decoder, i.e. as
+// `INPUT_*` words, for tests and benchmarks of the capture path.
+//
+// The display is scanned continuously from AS6 (MSD) to AS1 (LSD), each digit
+// with a high pulse of its strobe, while the digit, DS and the levels of RNG2,
+// NML and OVFL are steady. At the end of each gate time, nMUP is low for a few
+// scans, while the counter updates its memory, i.e. the display. As gate times
+// go up to 10 s, the signals are kept as steps of some µs rather than one word
+// per tick.
+
+// The firmware brings the decoder along, when it runs on the simulated MCU.
+#ifndef MSP430_SIM
+#include "1900a_ports.c"
+#endif
+
+#include <stddef.h>
+
+#define SIM_SETUP_US     20  // digit before its strobe rises
+#define SIM_STROBE_US    160 // strobe high
+#define SIM_HOLD_US      20  // digit after its strobe fell
+#define SIM_DIGIT_US     (SIM_SETUP_US + SIM_STROBE_US + SIM_HOLD_US)
+#define SIM_SCAN_US      (NUMBER_OF_DIGITS * SIM_DIGIT_US)
+#define SIM_UPDATE_SCANS 3 // with nMUP low
+#define SIM_MAX_STEPS    (1U << 20U)
+
+struct sim {
+  struct {
+    unsigned input;
+    u32 duration; // µs
+  } steps[SIM_MAX_STEPS];
+  size_t length;
+  // If not 0, the time of the setup, the strobe and the hold of each digit
+  // instead of the `SIM_*_US` above, for scans as fast as it gets.
+  u32 pace_us;
+};
+
+// What the display shows.
+struct sim_display {
+  u32 digits;        // BCD, MSD first
+  int decimal_point; // the digit with DS, 1 = MSD, or 0
+  unsigned levels;   // of `INPUT_RNG2`, `INPUT_NML` and `INPUT_OVFL`
+};
+
+static void sim_append(struct sim *sim, const unsigned input,
+                       const u32 duration) {
+  if (sim->length > 0U && sim->steps[sim->length - 1U].input == input) {
+    sim->steps[sim->length - 1U].duration += duration;
+  } else if (sim->length < SIM_MAX_STEPS) {
+    sim->steps[sim->length].input = input;
+    sim->steps[sim->length].duration = duration;
+    sim->length += 1U;
+  }
+}
+
+static u32 sim_scan_us(const struct sim *sim) {
+  return sim->pace_us != 0U ? 3U * NUMBER_OF_DIGITS * sim->pace_us
+                            : SIM_SCAN_US;
+}
+
+// Appends a scan of the display with nMUP at the given level.
+static void sim_scan(struct sim *sim, const struct sim_display *display,
+                     const unsigned mup) {
+  const bool paced = sim->pace_us != 0U;
+  for (int i = 1; i <= NUMBER_OF_DIGITS; ++i) {
+    const unsigned input =
+        mup | display->levels | DIGIT(display->digits, NUMBER_OF_DIGITS - i) |
+        (i == display->decimal_point ? INPUT_DS : 0U);
+    sim_append(sim, input, paced ? sim->pace_us : SIM_SETUP_US);
+    sim_append(sim, input | (INPUT_AS6 << (i - 1)),
+               paced ? sim->pace_us : SIM_STROBE_US);
+    sim_append(sim, input, paced ? sim->pace_us : SIM_HOLD_US);
+  }
+}
+
+// Appends a gate time of (about) the given length, while the display shows the
+// `previous` reading, and the memory update to the `next` one.
+static void sim_gate(struct sim *sim, const struct sim_display *previous,
+                     const struct sim_display *next, const u32 gate_us) {
+  for (u32 t = 0U; t < gate_us; t += sim_scan_us(sim)) {
+    sim_scan(sim, previous, INPUT_nMUP);
+  }
+  for (int i = 0; i < SIM_UPDATE_SCANS; ++i) {
+    sim_scan(sim, next, 0U);
+  }
+}
+
+// Captures the simulated inputs like the firmware does, i.e. on each rising
+// edge of the strobes and on each falling edge of nMUP, and prints the readings
+// to `text`, if not null. Returns the number of readings.
+static size_t sim_capture(const struct sim *sim, const bool lock_on,
+                          char *text) {
+  size_t num_readings = 0U;
+  struct decoder_state state = {0U, 0, 0};
+  unsigned previous = sim->length > 0U ? sim->steps[0].input : 0U;
+  for (size_t i = 1U; i < sim->length; ++i) {
+    const unsigned input = sim->steps[i].input;
+    const unsigned rising = input & ~previous;
+    const unsigned falling = previous & ~input;
+    previous = input;
+    if ((rising & (INPUT_AS6 | INPUT_AS5 | INPUT_AS4 | INPUT_AS3 | INPUT_AS2 |
+                   INPUT_AS1)) == 0U &&
+        (falling & INPUT_nMUP) == 0U) {
+      continue;
+    }
+    state = decode(state, lock_on && num_readings == 0U ? HELD_INPUT(input)
+                                                        : input);
+    if (state.next_digit > NUMBER_OF_DIGITS) {
+      if (text != nullptr) {
+        text = print_reading(
+            text, state.reading, state.decimal_point_digit,
+            (input & INPUT_OVFL) != 0U,
+            determine_unit((input & INPUT_NML) != 0U,
+                           (input & INPUT_RNG2) != 0U,
+                           state.decimal_point_digit != 0));
+      }
+      num_readings += 1U;
+      state = (struct decoder_state){0U, UPDATE_END, 0};
+    }
+  }
+  return num_readings;
+}
+
+#ifdef MSP430_SIM
+// Converts the simulated inputs to the edges of the ports of the simulated MCU,
+// see `mcu_sim.c`, with Tx idle. Returns their number.
+static size_t sim_edges(const struct sim *sim, struct mcu_edge *edges) {
+  uint64_t time = 0U;
+  for (size_t i = 0U; i < sim->length; ++i) {
+    u8 port1 = Tx;
+    u8 port2 = 0U;
+    for (unsigned pin = 1U; pin <= 0x80U; pin <<= 1U) {
+      if ((remap_ports((u8)pin, 0U) & sim->steps[i].input) != 0U) {
+        port1 = (u8)(port1 | pin);
+      }
+      if ((remap_ports(0U, (u8)pin) & sim->steps[i].input) != 0U) {
+        port2 = (u8)(port2 | pin);
+      }
+    }
+    edges[i] = (struct mcu_edge){time, port1, port2};
+    time += sim->steps[i].duration;
+  }
+  return sim->length;
+}
+#endif
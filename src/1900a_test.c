@@ -0,0 +1,119 @@
+// Tests the 1900A logic that does not depend on the MSP430.
+
+#include "1900a_sim.c"
+
+#include <unity.h>
+
+#include <stdlib.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// The pin assignment of the DOU, independent of `enum port1` and `port2`.
+static const struct {
+  int port;
+  unsigned pin;
+  unsigned input;
+} pins_[] = {
+    {1, 0x01U, INPUT_B},    {1, 0x02U, INPUT_AS1},  {1, 0x08U, INPUT_RNG2},
+    {1, 0x10U, INPUT_NML},  {1, 0x20U, INPUT_OVFL}, {1, 0x40U, INPUT_AS3},
+    {1, 0x80U, INPUT_AS2},  {2, 0x01U, INPUT_nMUP}, {2, 0x02U, INPUT_C},
+    {2, 0x04U, INPUT_D},    {2, 0x08U, INPUT_AS6},  {2, 0x10U, INPUT_AS5},
+    {2, 0x20U, INPUT_AS4},  {2, 0x40U, INPUT_A},    {2, 0x80U, INPUT_DS}};
+
+static unsigned reference_inputs(const u8 port1, const u8 port2) {
+  unsigned inputs = 0U;
+  for (size_t i = 0U; i < sizeof pins_ / sizeof pins_[0]; ++i) {
+    const u8 port = pins_[i].port == 1 ? port1 : port2;
+    inputs |= (port & pins_[i].pin) != 0U ? pins_[i].input : 0U;
+  }
+  return inputs;
+}
+
+void test_remap_ports(void) {
+  for (unsigned state = 0U; state <= 0xffffU; ++state) {
+    const u8 port1 = (u8)state;
+    const u8 port2 = (u8)(state >> 8U);
+    TEST_ASSERT_EQUAL_HEX16(reference_inputs(port1, port2),
+                            remap_ports(port1, port2));
+  }
+}
+
+void test_print_reading(void) {
+  char buffer[MAX_READING_SIZE];
+  print_reading(buffer, 0x001b234U, 4, false, MHz);
+  TEST_ASSERT_EQUAL_STRING(" 001.234MHz\r\n", buffer);
+  print_reading(buffer, 0xb000001U, 1, false, us);
+  TEST_ASSERT_EQUAL_STRING(" .000001us\r\n", buffer);
+  print_reading(buffer, 0x999999U, 0, true, NoUnit);
+  TEST_ASSERT_EQUAL_STRING(">999999\r\n", buffer);
+}
+
+static struct sim sim_;
+
+static const struct sim_display displays_[] = {
+    {0x001234U, 4, INPUT_RNG2},             // 001.234 MHz
+    {0x123456U, 6, 0U},                     // 12345.6 ms
+    {0x000001U, 1, INPUT_NML},              // .000001 us
+    {0x999999U, 0, INPUT_OVFL},             // overflow
+    {0x123456U, 5, INPUT_RNG2 | INPUT_NML}, // 1234.56 kHz
+};
+
+#define SIMULATED_READINGS                                                     \
+  " 12345.6ms\r\n .000001us\r\n>999999\r\n 1234.56kHz\r\n"
+
+// Simulates gate times from 10 ms to 10 s, starting with the first of the
+// `displays_`. If `glitches`, there is bus noise from the front panel switches
+// in every gate time.
+static void simulate_readings(const bool glitches) {
+  static const u32 gate_times[] = {10000U, 100000U, 1000000U, 10000000U};
+  sim_.length = 0U;
+  for (size_t i = 0U; i < 4U; ++i) {
+    if (glitches) {
+      sim_scan(&sim_, &displays_[i], INPUT_nMUP);
+      for (int j = 0; j < 4; ++j) {
+        const unsigned noise = (unsigned)rand() & 0xbfffU;
+        sim_append(&sim_, noise, 1U + (u32)rand() % 50U);
+      }
+    }
+    sim_gate(&sim_, &displays_[i], &displays_[i + 1U], gate_times[i]);
+  }
+  sim_scan(&sim_, &displays_[4], INPUT_nMUP);
+}
+
+void test_capture(void) {
+  char text[8U * MAX_READING_SIZE];
+  simulate_readings(false);
+  // one reading per memory update, although it lasts several scans
+  TEST_ASSERT_EQUAL_size_t(4U, sim_capture(&sim_, false, text));
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, text);
+}
+
+void test_capture_lock_on(void) {
+  // the held reading comes first, as it is on display from the start
+  char text[8U * MAX_READING_SIZE];
+  simulate_readings(false);
+  TEST_ASSERT_EQUAL_size_t(5U, sim_capture(&sim_, true, text));
+  TEST_ASSERT_EQUAL_STRING(" 001.234MHz\r\n" SIMULATED_READINGS, text);
+}
+
+void test_capture_glitches(void) {
+  // incomplete scans are dropped
+  char text[8U * MAX_READING_SIZE];
+  srand(1900);
+  for (int i = 0; i < 64; ++i) {
+    simulate_readings(true);
+    sim_capture(&sim_, false, text);
+    TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, text);
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_remap_ports);
+  RUN_TEST(test_print_reading);
+  RUN_TEST(test_capture);
+  RUN_TEST(test_capture_lock_on);
+  RUN_TEST(test_capture_glitches);
+  return UNITY_END();
+}
@@ -17,12 +17,16 @@
 // S1 -> S3 -> S2 -> S4. Also, there is no guarantee, which strobe comes first
 // after a rising edge of nT.
 // When the display flashes to indicate overload, there are strobes only every
-// second period of nT.
+// second period of nT. The decoder holds on to an overload reading, and if the
+// next period passes without strobes, it returns the held reading again, so
+// that readings keep coming at the full rate. These are printed with `=`
+// instead of `>`.
 // There is a systematic glitch in the clock's high cycle when it coincides
 // with S1 or S4, which is why the original DOU has a low-pass filter on that
 // line (15k/68p).
 
 #include "dou.c"
+#include "si.c"
 
 #define NUMBER_OF_DIGITS 4 // 3½
 #define MAX_READING_SIZE                                                       \
@@ -42,8 +46,27 @@
 #define IS_OVERLOAD(input) (((input) & INPUT_W) != 0U)
 #define IS_POSITIVE(input) (((input) & INPUT_Y) != 0U)
 
+// Instead of the low-pass filter, S can be filtered in software. With more than
+// one sample, the inputs are sampled that many times on each edge of S, and S
+// is taken to be at the level of the majority of the samples. Only rising
+// edges of that level are passed on to the decoder, so that glitches shorter
+// than half the sampling window are ignored.
+#ifndef GLITCH_FILTER_SAMPLES
+#define GLITCH_FILTER_SAMPLES 1
+#endif
+_Static_assert(GLITCH_FILTER_SAMPLES % 2 == 1, "a majority needs odd samples");
+
+// `next_digit` while waiting for the end of the period of the previous reading
+#define PERIOD_END   (-1)
+// `next_digit` of a complete reading
+#define DECODED      (NUMBER_OF_DIGITS + 1)
+// `next_digit` after a period without strobes, `reading` is the held one
+#define BLANK_PERIOD (NUMBER_OF_DIGITS + 2)
+
 struct decoder_state {
   // The reading fits into 16 bits: 4 strobes * 4 bit BCD digit.
+  // Until the first digit of a period is captured, it holds the previous
+  // reading, if that indicated overload, or 0.
   unsigned reading;
   int next_digit;
 };
@@ -53,11 +76,15 @@ static struct decoder_state decode(const struct decoder_state state,
   switch (state.next_digit) {
   default:
     if ((input & INPUT_T) == 0U) {
-      return (struct decoder_state){0U, 1};
+      return (struct decoder_state){state.reading, 1};
     }
     return state;
   case 1:
     if ((input & INPUT_T) != 0U) {
+      // the flashing display skips every second period during overload
+      if (state.reading != 0U) {
+        return (struct decoder_state){state.reading, BLANK_PERIOD};
+      }
       return (struct decoder_state){0U, 0};
     }
     if ((input & INPUT_S) != 0U && (input & INPUT_S1) != 0U) {
@@ -87,19 +114,160 @@ static struct decoder_state decode(const struct decoder_state state,
                                     state.next_digit + 1};
     }
     return state;
-  case 5:
+  case PERIOD_END:
+  case DECODED:
     // wait for the end of the period, until T goes high again
     if ((input & INPUT_T) != 0U) {
-      return (struct decoder_state){0U, 0};
+      return (struct decoder_state){state.reading, 0};
     }
     return state;
   }
 }
 
+// Votes on the level of S over the samples taken after an edge of S and
+// updates the filtered `level`. Returns the first sample, which is closest to
+// the edge, with S set only if the filtered level has risen. Edges that are
+// voted down are counted as `glitches`, if given.
+static unsigned filter_strobe(bool *level, u16 *glitches,
+                              const unsigned samples[GLITCH_FILTER_SAMPLES]) {
+  int highs = 0;
+  for (int i = 0; i < GLITCH_FILTER_SAMPLES; ++i) {
+    highs += (samples[i] & INPUT_S) != 0U;
+  }
+  const bool high = 2 * highs > GLITCH_FILTER_SAMPLES;
+  const bool rising = high && !*level;
+  if (glitches != nullptr && ((samples[0] & INPUT_S) != 0U) != *level &&
+      high == *level) {
+    *glitches += 1U;
+  }
+  *level = high;
+  return rising ? samples[0] | INPUT_S : samples[0] & ~(unsigned)INPUT_S;
+}
+
+// Returns the state to decode the next reading with, after `state` returned
+// one. Overload readings are held for a following blank period, but not for
+// a second one, if the display stays blank.
+static struct decoder_state decode_next(const struct decoder_state state) {
+  // A blank period is detected at its end, whereas a reading is complete
+  // before the end of its period.
+  if (state.next_digit == BLANK_PERIOD) {
+    return (struct decoder_state){0U, 0};
+  }
+  const unsigned held =
+      IS_OVERLOAD(DIGIT(state.reading, 3)) ? state.reading : 0U;
+  return (struct decoder_state){held, PERIOD_END};
+}
+
+// Packs an input of the decoder and the state that it led to into a word of
+// the decoder trace: the input in the top byte, `next_digit` below it, and the
+// reading in the lower half.
+static u32 trace_word(const unsigned input, const struct decoder_state state) {
+  return (u32)input << 24U | (u32)(u8)state.next_digit << 16U |
+         (u16)state.reading;
+}
+
+// Sends the telemetry every that many periods of nT, if not 0.
+#ifndef TELEMETRY_INTERVAL
+#define TELEMETRY_INTERVAL 0
+#endif
+_Static_assert(TELEMETRY_INTERVAL <= 255, "too many periods to count");
+
+// The troubles of the decoder and the length of the periods of nT, which tell
+// of degraded signals before the readings go wrong. The counters wrap around.
+struct telemetry {
+  u16 aborted;  // readings with strobes missing at the end of the period
+  u16 missed;   // periods without strobes, other than the blank ones
+  u16 glitches; // edges of S that were rejected by the filter
+  u16 overruns; // readings complete before the previous message was out
+  // of the periods since `telemetry_restart()`, in ACLK ticks
+  u16 period_start;
+  u16 period_min;
+  u16 period_max;
+  u32 period_sum;
+  u8 periods;
+  bool started; // `period_start` is valid
+};
+
+// Counts the errors of the decoder, given its state before and after an
+// input. Returns true, if a period has started.
+static bool telemetry_decoded(struct telemetry *t,
+                              const struct decoder_state before,
+                              const struct decoder_state after) {
+  if (before.next_digit == 1 && after.next_digit == 0) {
+    t->missed += 1U;
+  } else if (before.next_digit >= 2 && before.next_digit <= NUMBER_OF_DIGITS &&
+             after.next_digit <= 1) {
+    t->aborted += 1U;
+  }
+  return before.next_digit == 0 && after.next_digit == 1;
+}
+
+// Records the start of a period at the given time in ACLK ticks. Periods must
+// be shorter than 2^16 ticks, which the watchdog ensures.
+static void telemetry_period(struct telemetry *t, const u16 now) {
+  if (t->started) {
+    const u16 period = (u16)(now - t->period_start);
+    const bool first = t->periods == 0U;
+    t->period_min = first || period < t->period_min ? period : t->period_min;
+    t->period_max = first || period > t->period_max ? period : t->period_max;
+    t->period_sum += period;
+    t->periods += 1U;
+  }
+  t->period_start = now;
+  t->started = true;
+}
+
+// Starts the next interval of the period statistics.
+static void telemetry_restart(struct telemetry *t) {
+  t->period_sum = 0U;
+  t->periods = 0U;
+}
+
+// `#H <aborted> <missed> <glitches> <overruns> <min> <mean> <max>\r\n` gives
+// the counters and the statistics of the periods of nT in ACLK ticks, which
+// are 0, if no period has passed.
+#define MAX_TELEMETRY_SIZE 47
+
+static char *print_telemetry(char buf[static MAX_TELEMETRY_SIZE],
+                             const struct telemetry *t) {
+  const char *end = &buf[MAX_TELEMETRY_SIZE - 1];
+  const bool none = t->periods == 0U;
+  const unsigned values[] = {
+      t->aborted,
+      t->missed,
+      t->glitches,
+      t->overruns,
+      none ? 0U : t->period_min,
+      none ? 0U : (unsigned)(t->period_sum / t->periods),
+      none ? 0U : t->period_max};
+  char *dst = print_str(buf, end, "#H");
+  for (unsigned i = 0U; i < sizeof values / sizeof values[0]; ++i) {
+    dst = print_str(dst, end, " ");
+    dst = print_uint(dst, end, values[i]);
+  }
+  dst = print_str(dst, end, "\r\n");
+  *dst = '\0';
+  return dst;
+}
+
+// Converts a reading of the decoder to a signed count without unit, since the
+// 8000A indicates neither range nor function.
+static struct si_value reading_to_si(const unsigned reading) {
+  const unsigned msd = DIGIT(reading, 3);
+  // digit 3 & 4 are swapped, because the strobes appear out of order
+  const i32 digits = bcd_to_binary(DIGIT(reading, 1) << 8U |
+                                   DIGIT(reading, 2) << 4U | DIGIT(reading, 0));
+  if (digits < 0) {
+    return (struct si_value){0, 0, SI_INVALID};
+  }
+  const i32 value = ((msd & INPUT_Z) ? 1000 : 0) + digits;
+  return (struct si_value){IS_POSITIVE(msd) ? value : -value, 0, SI_NONE};
+}
+
 static char *print_reading(char buf[static MAX_READING_SIZE],
-                           const unsigned reading) {
+                           const unsigned reading, const bool held) {
   const unsigned msd = DIGIT(reading, 3);
-  buf[0] = IS_OVERLOAD(msd) ? '>' : ' ';
+  buf[0] = held ? '=' : IS_OVERLOAD(msd) ? '>' : ' ';
   buf[1] = IS_POSITIVE(msd) ? '+' : '-';
   buf[2] = (msd & INPUT_Z) ? '1' : ' ';
   // digit 3 & 4 are swapped, because the strobes appear out of order
@@ -111,3 +279,60 @@ static char *print_reading(char buf[static MAX_READING_SIZE],
   buf[8] = '\0';
   return &buf[8];
 }
+
+// The largest output is that of the burst format, if built with it.
+#if BURST_FORMAT
+#define MAX_OUTPUT_SIZE MAX_BURST_SIZE
+#elif SI_FORMATS
+#define MAX_OUTPUT_SIZE MAX_CSV_SIZE
+#else
+#define MAX_OUTPUT_SIZE MAX_READING_SIZE
+#endif
+_Static_assert(MAX_READING_SIZE <= MAX_OUTPUT_SIZE, "output buffer too small");
+_Static_assert(!SI_FORMATS || MAX_CSV_SIZE <= MAX_OUTPUT_SIZE,
+               "output buffer too small");
+
+// The held flag is packed above the digits for the burst format.
+#define BURST_HELD (0x10000U)
+// ACLK ticks per tenth of a second, the unit of `config.burst_deadline`, with
+// ACLK at nominally 12 kHz.
+#define DEADLINE_TICKS 1200U
+
+// Prints the reading in the configured format, including the line ending.
+// Returns false, if there is nothing to send, because the average or the burst
+// is not complete yet.
+static bool print_output(char buf[static MAX_OUTPUT_SIZE],
+                         const struct config *config,
+                         struct si_average *average, struct burst *burst,
+                         const unsigned reading, const bool held,
+                         const u16 sequence, const u32 timestamp) {
+  if (config->format == FORMAT_FIXED) {
+    print_reading(buf, reading, held);
+    return true;
+  }
+#if BURST_FORMAT
+  if (config->format == FORMAT_BURST) {
+    return burst_add(buf, burst, reading | (held ? BURST_HELD : 0U), sequence,
+                     timestamp, config->burst_size,
+                     (u32)config->burst_deadline * DEADLINE_TICKS);
+  }
+#else
+  (void)burst;
+#endif
+#if SI_FORMATS
+  struct si_value mean;
+  bool overload;
+  if (!si_average_add(average, reading_to_si(reading),
+                      IS_OVERLOAD(DIGIT(reading, 3)), config->averaging, &mean,
+                      &overload)) {
+    return false;
+  }
+  print_value(buf, config->format, mean, overload, sequence, timestamp);
+  return true;
+#else
+  (void)average;
+  (void)sequence;
+  (void)timestamp;
+  return false;
+#endif
+}
@@ -0,0 +1,159 @@
+// Checks `decode()` of the 8000A against its reference model, so that the
+// firmware's decoder can be optimized without changing what it decodes.
+
+#include "8000a_sim.c"
+#include "equivalence.c"
+
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// The decoder as it was before any optimization. Keep it readable and do not
+// change it, unless the intended behaviour changes.
+static struct decoder_state
+reference_decode(const struct decoder_state state, const unsigned input) {
+  const bool period_end = (input & INPUT_T) != 0U;
+  const bool clock = (input & INPUT_S) != 0U;
+  const bool s1 = (input & INPUT_S1) != 0U;
+  const bool s4 = (input & INPUT_S4) != 0U;
+  const int next = state.next_digit;
+  if (next == 1 && period_end) {
+    // a period without strobes is blank, if an overload reading is held
+    return (struct decoder_state){state.reading,
+                                  state.reading != 0U ? BLANK_PERIOD : 0};
+  }
+  if (next >= 2 && next <= NUMBER_OF_DIGITS && period_end) {
+    return (struct decoder_state){0U, 0}; // aborted
+  }
+  if (next == PERIOD_END || next == DECODED) {
+    return (struct decoder_state){state.reading, period_end ? 0 : next};
+  }
+  if (next < 1 || next > NUMBER_OF_DIGITS) {
+    return (struct decoder_state){state.reading, period_end ? next : 1};
+  }
+  if (!clock) {
+    return state;
+  }
+  if (next == 1) {
+    return s1 ? (struct decoder_state){ZYXW(input), 2} : state;
+  }
+  if (next == NUMBER_OF_DIGITS) {
+    return s4 ? (struct decoder_state){state.reading << 4U | ZYXW(input), 5}
+              : state;
+  }
+  if (s1) {
+    return state; // glitch of the clock on S1
+  }
+  if (s4) {
+    return (struct decoder_state){0U, 1}; // out of order
+  }
+  return (struct decoder_state){state.reading << 4U | ZYXW(input), next + 1};
+}
+
+static struct decoder_state reference_next(const struct decoder_state state) {
+  const bool blank = state.next_digit == BLANK_PERIOD;
+  const bool overload = IS_OVERLOAD(DIGIT(state.reading, 3));
+  return (struct decoder_state){!blank && overload ? state.reading : 0U,
+                                blank ? 0 : PERIOD_END};
+}
+
+static struct decoder_state reference_;
+static struct decoder_state optimized_;
+
+static void reset(void) {
+  reference_ = (struct decoder_state){0U, 0};
+  optimized_ = (struct decoder_state){0U, 0};
+}
+
+// Compares what the firmware gets to see: whether a reading is complete, and
+// if so, the reading and whether it is held.
+static bool step(const unsigned input) {
+  reference_ = reference_decode(reference_, input);
+  optimized_ = decode(optimized_, input);
+  const bool complete = reference_.next_digit > NUMBER_OF_DIGITS;
+  if (complete != (optimized_.next_digit > NUMBER_OF_DIGITS)) {
+    return false;
+  }
+  if (complete) {
+    if (reference_.reading != optimized_.reading ||
+        reference_.next_digit != optimized_.next_digit) {
+      return false;
+    }
+    reference_ = reference_next(reference_);
+    optimized_ = decode_next(optimized_);
+  }
+  return true;
+}
+
+static const struct equivalence equivalence_ = {reset, step};
+
+#define ALL_INPUTS 0xffU
+
+void test_all_inputs(void) {
+  unsigned alphabet[ALL_INPUTS + 1U];
+  for (unsigned i = 0U; i <= ALL_INPUTS; ++i) {
+    alphabet[i] = i;
+  }
+  if (!check_exhaustive(&equivalence_, alphabet, ALL_INPUTS + 1U, 3U)) {
+    TEST_FAIL_MESSAGE(equivalence_failure_);
+  }
+}
+
+void test_strobe_sequences(void) {
+  // long enough for a reading, its period end and a blank period
+  static const unsigned alphabet[] = {
+      INPUT_T,
+      INPUT_T | INPUT_S | INPUT_W,
+      0U,
+      INPUT_S | INPUT_Z,
+      INPUT_S | INPUT_S1 | INPUT_W,
+      INPUT_S | INPUT_S1 | INPUT_Y,
+      INPUT_S | INPUT_S4 | INPUT_X,
+      INPUT_S | INPUT_S1 | INPUT_S4,
+  };
+  if (!check_exhaustive(&equivalence_, alphabet,
+                        sizeof alphabet / sizeof alphabet[0], 8U)) {
+    TEST_FAIL_MESSAGE(equivalence_failure_);
+  }
+}
+
+static unsigned stream_[1U << 20U];
+
+void test_random_stream(void) {
+  srand(8000);
+  random_stream(stream_, sizeof stream_ / sizeof stream_[0], ALL_INPUTS);
+  if (!check_stream(&equivalence_, stream_,
+                    sizeof stream_ / sizeof stream_[0])) {
+    TEST_FAIL_MESSAGE(equivalence_failure_);
+  }
+}
+
+static struct sim sim_;
+
+void test_fuzzed_stream(void) {
+  // periods of all kinds, with bits flipped here and there
+  static const unsigned normal[] = {0x6U, 0x1U, 0x2U, 0x3U};
+  static const unsigned overload[] = {0xbU, 0x9U, 0x9U, 0x9U};
+  srand(8001);
+  for (int pass = 0; pass < 256; ++pass) {
+    sim_.length = 0U;
+    while (sim_.length + SIM_PERIOD_TICKS <= SIM_MAX_TICKS) {
+      const int kind = rand() % 3;
+      sim_period(&sim_, kind == 0 ? normal : kind == 1 ? overload : nullptr);
+    }
+    fuzz_stream(sim_.inputs, sim_.length, ALL_INPUTS, 50);
+    if (!check_stream(&equivalence_, sim_.inputs, sim_.length)) {
+      TEST_FAIL_MESSAGE(equivalence_failure_);
+    }
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_all_inputs);
+  RUN_TEST(test_strobe_sequences);
+  RUN_TEST(test_random_stream);
+  RUN_TEST(test_fuzzed_stream);
+  return UNITY_END();
+}
@@ -1,37 +1,182 @@
 // MSP430G2452-based firmware for the 8000A DOU.
 
-#include "8000a.c"
+#include "8000a_ports.c"
 #include "msp430/g2231.c"
 
-// Masks for the I/O ports.
-enum port1 {  // pin  | function
-  Z = 0x01U,  // P1.0 | BCD 1 ╮
-  Y = 0x02U,  // P1.1 | BCD 2 ├ digit
-  X = 0x04U,  // P1.2 | BCD 4 │
-  W = 0x08U,  // P1.3 | BCD 8 ╯
-  T = 0x10U,  // P1.4 | inverted nT with fixed logic levels
-  S = 0x20U,  // P1.5 | strobe clock
-  Tx = 0x40U, // P1.6 | SDO
-};
-enum port2 {  // pin       | function
-  S1 = 0x40U, // P2.6/XIN  | MSD (DS1) strobe
-  S4 = 0x80U, // P2.7/XOUT | LSD (DS4) strobe
-};
+// Built with `DEBUG_PROBES=1`, P1.7 is raised on entry of each ISR and lowered
+// once the decoder has taken the input, or at the end of `on_usi()`, so that a
+// scope shows the latency from the edges of the bus to the decoder and the
+// time spent in the ISRs. P1.7 is Rx otherwise, so no commands are received.
+#ifndef DEBUG_PROBES
+#define DEBUG_PROBES 0
+#endif
+#if DEBUG_PROBES
+#define probe_high() (P1OUT |= Rx)
+#define probe_low()  (P1OUT = (u8)(P1OUT & ~Rx))
+#else
+#define probe_high()
+#define probe_low()
+#endif
+// The edges of Rx that start receiving a command.
+#define RX_IE (DEBUG_PROBES ? 0U : Rx)
+
+static bool strobe_level_; // of S, if filtered
+// Without telemetry, it takes no RAM, and glitches are not counted.
+#if TELEMETRY_INTERVAL > 0
+static struct telemetry telemetry_;
+#define GLITCH_COUNTER (&telemetry_.glitches)
+#else
+#define GLITCH_COUNTER nullptr
+#endif
 
 static unsigned capture_input(void) {
-  const u8 port1 = P1IN;
-  const u8 port2 = P2IN;
-  return (port1 & Z ? INPUT_Z : 0U) | (port1 & Y ? INPUT_Y : 0U) |
-         (port1 & X ? INPUT_X : 0U) | (port1 & W ? INPUT_W : 0U) |
-         (port1 & T ? INPUT_T : 0U) | (port1 & S ? INPUT_S : 0U) |
-         (port2 & S1 ? INPUT_S1 : 0U) | (port2 & S4 ? INPUT_S4 : 0U);
+  unsigned samples[GLITCH_FILTER_SAMPLES];
+  for (int i = 0; i < GLITCH_FILTER_SAMPLES; ++i) {
+    samples[i] = remap_ports(P1IN, P2IN);
+  }
+  const unsigned input = GLITCH_FILTER_SAMPLES > 1
+                             ? filter_strobe(&strobe_level_, GLITCH_COUNTER,
+                                             samples)
+                             : samples[0];
+  // Both edges of T wake the decoder, so that it sees each period end, even
+  // if there are no strobes, as in the blank periods of the flashing display.
+  // If filtered, S wakes it on the edge away from the filtered level.
+  // If the edge has passed already, the interrupt flag is set right away.
+  unsigned ies = P1IES & ~(unsigned)(T | S);
+  ies |= (input & INPUT_T) != 0U ? T : 0U;
+  ies |= GLITCH_FILTER_SAMPLES > 1 && strobe_level_ ? S : 0U;
+  P1IES = (u8)ies;
+  return input;
+}
+
+// The clocks, as configured by `main()`.
+#define SMCLK_FREQUENCY (16000000UL)
+#define ACLK_FREQUENCY  (12000UL) // VLOCLK, nominal
+
+// The timing of the serial line at each of the `SERIAL_BAUD_RATES`.
+#define HALF_BIT_TICKS(rate) (SMCLK_FREQUENCY / (rate) / 2U),
+static const u16 half_bit_ticks_[NUM_BAUD_RATES] = {
+    SERIAL_BAUD_RATES(HALF_BIT_TICKS)};
+#define ACLK_CHAR_TICKS(rate) SERIAL_CHAR_TICKS(ACLK_FREQUENCY, (rate)),
+static const u8 aclk_char_ticks_[NUM_BAUD_RATES] = {
+    SERIAL_BAUD_RATES(ACLK_CHAR_TICKS)};
+_Static_assert(DEADLINE_TICKS == ACLK_FREQUENCY / 10U, "ACLK mismatch");
+
+static void send_serial(const char *msg);
+static bool store_config(const struct config *c);
+
+NOINIT static struct retained retained_;
+#if DECODER_TRACE > 0
+NOINIT static struct trace trace_;
+#endif
+INFO static volatile struct config stored_config_;
+// Like `retained_`, the settings in use survive a watchdog reset, even if they
+// are not stored.
+NOINIT static struct config config_;
+
+// since the reset in ACLK ticks, the time of sending and receiving is estimated
+static volatile u32 timestamp_;
+
+// The latest complete reading, which is sent right away on `TRIGGER_CHAR`, or
+// another message, if not `output_valid_`. The largest message is the output,
+// a part of the status, or the telemetry, if enabled.
+#define MAX_OUTPUT_OR_STATUS_SIZE                                              \
+  (MAX_OUTPUT_SIZE > MAX_STATUS_SIZE ? MAX_OUTPUT_SIZE : MAX_STATUS_SIZE)
+#if TELEMETRY_INTERVAL > 0
+#define MAX_MESSAGE_SIZE                                                       \
+  (MAX_TELEMETRY_SIZE > MAX_OUTPUT_OR_STATUS_SIZE ? MAX_TELEMETRY_SIZE         \
+                                                  : MAX_OUTPUT_OR_STATUS_SIZE)
+#else
+#define MAX_MESSAGE_SIZE MAX_OUTPUT_OR_STATUS_SIZE
+#endif
+#if DECODER_TRACE > 0
+_Static_assert(MAX_TRACE_SIZE <= MAX_MESSAGE_SIZE, "buffer too small");
+#endif
+_Static_assert(MAX_REPORT_SIZE <= MAX_MESSAGE_SIZE, "buffer too small");
+static char output_[MAX_MESSAGE_SIZE];
+static volatile bool output_valid_;
+
+// The message that is being sent by `on_usi()`, if any.
+static const char *volatile sending_;
+static u8 frame_check_; // CRC-8 of the line so far
+static u8 trailer_;     // number of frame check characters sent
+
+// Commands are received while decoding, see `on_port1()` and `on_usi()`, and
+// executed between readings.
+static volatile bool receiving_;
+static volatile char command_[MAX_COMMAND_SIZE];
+static volatile u8 command_length_; // beyond `MAX_COMMAND_SIZE` if too long
+static volatile bool command_ready_;
+static volatile u16 command_errors_;
+
+// A reading has been requested, but not sent yet.
+static volatile bool trigger_;
+static volatile u32 trigger_time_; // `timestamp_` of the request
+static u16 trigger_latency_;       // until the latest request was answered
+
+// Sends the burst frame in progress, if any, as the output buffer is needed for
+// another message.
+static void flush_burst(struct burst *burst) {
+#if BURST_FORMAT
+  if (burst->count == 0U) {
+    return;
+  }
+  burst_finish(output_, burst);
+  send_serial(output_);
+  retained_.sequence += 1U;
+  retained_commit(&retained_);
+#else
+  (void)burst;
+#endif
+}
+
+#if DECODER_TRACE > 0
+// Sends the decoder trace, oldest word first. The watchdog is serviced for
+// each line, as the whole trace may take longer than its interval.
+static void send_trace(void) {
+  output_valid_ = false;
+  for (unsigned i = 0U; i < trace_.count; ++i) {
+    WDTCTL = WDT_UNLOCK | WDT_CLEAR | WDT_ACLK | WDT_8192;
+    print_trace(output_, trace_at(&trace_, i));
+    send_serial(output_);
+  }
 }
+#endif
 
-static void send_serial(const char msg[static MAX_READING_SIZE]);
+// Returns the time since the reset in ACLK ticks, also while the timer clocks
+// the serial line.
+static u32 aclk_now(void) {
+  disable_interrupts();
+  const u32 now = timestamp_ + ((TACTL & TACTL_SMCLK) != 0U ? 0U : TAR);
+  enable_interrupts();
+  return now;
+}
+
+// Takes the count of the timer into `timestamp_` and starts it over. Called
+// once per reading, so that the timer, which wraps after about 5.5 s of ACLK,
+// does not lose ticks while nothing is sent. Returns the time since the reset.
+static u32 fold_timer(void) {
+  disable_interrupts();
+  timestamp_ += TAR;
+  TACTL |= TACTL_CLEAR;
+  const u32 now = timestamp_;
+  enable_interrupts();
+  return now;
+}
 
 int main(void) {
   WDTCTL = WDT_UNLOCK | WDT_HOLD;
 
+  // After a watchdog reset, carry on with the retained state.
+  const bool warm_restart = (IFG1 & IFG1_WDT) && retained_valid(&retained_);
+  IFG1 = (u8)(IFG1 & ~IFG1_WDT);
+  if (warm_restart) {
+    retained_.resets += 1U;
+  } else {
+    retained_ = (struct retained){0U, 0U, 0U};
+  }
+  retained_commit(&retained_);
+
   // Clear P2SEL reasonably early, because excess current will flow from
   // the oscillator driver output at P2.7.
   P2SEL = 0U;
@@ -43,20 +188,21 @@ int main(void) {
   // store the constants to the info memory.
   BCSCTL1 = CAL_BC1_16MHz;
   DCOCTL = CAL_DCO_16MHz;
-#define SMCLK_FREQUENCY (16000000UL)
   BCSCTL3 = 0x24U; // ACLK = VLOCLK
 
-  TACTL = TACTL_SMCLK;  // use SMCLK for best resolution of serial baudrate
+  // While decoding, the timer counts ACLK for the restart time and the
+  // timestamps. While sending or receiving, it clocks the serial line.
+  TACTL = TACTL_ACLK | TACTL_CLEAR | TACTL_CONTINUOUS;
   USICCTL = USI_TACCR0; // clock serial via TimerA
 
   // 1. Make sure to pull Tx high ASAP.
   // 2. All inputs shall have pull-ups, because the comparator outputs are OD.
-  P1OUT = Z | Y | X | W | T | S | Tx;
-  P1DIR = Tx;
-  P1IES = PxIES_FALLING_EDGE(T) | PxIES_RISING_EDGE(S);
+  P1OUT = Z | Y | X | W | T | S | Tx | RX_IE;
+  P1DIR = Tx | (DEBUG_PROBES ? Rx : 0U);
+  P1IES = PxIES_FALLING_EDGE(T | Rx) | PxIES_RISING_EDGE(S);
   P1IFG = 0U; // setting PxIES could trigger interrupt
   P1SEL = 0U; // USI will be configured to P1.6 later to keep the line high
-  P1REN = Z | Y | X | W | T | S; // enable resistors on all inputs
+  P1REN = Z | Y | X | W | T | S | Rx; // enable resistors on all inputs
 
   P2OUT = S1 | S4; // all inputs shall have pull-ups
   P2DIR = 0U;      // all pins are input
@@ -64,36 +210,192 @@ int main(void) {
 
   enable_interrupts();
 
-  for (;;) {
-    P1IE = S;
-    struct decoder_state state = {0U, 0};
-    for (; state.next_digit <= NUMBER_OF_DIGITS;
-         state = decode(state, capture_input())) {
-      // The watchdog timer will reset the device, if no measurement has been
-      // detected for a while.
-      // ACLK = VLOCLK = max. 20 kHz, according to datasheet
-      // 6 measurements per seconds, typically, according to service manual
-      // 20 kHz / 8192 = ~2,4 Hz
-      // gives enough headroom to transmit the reading at 19200 baud
-      // and allows to survive flashing display where there might be no digits
-      //  in a reading.
-      //WDTCTL = WDT_UNLOCK | WDT_CLEAR | WDT_ACLK | WDT_8192;
+  // The watchdog timer will reset the device, if no measurement has been
+  // detected for a while.
+  // ACLK = VLOCLK = max. 20 kHz, according to datasheet
+  // 6 measurements per seconds, typically, according to service manual
+  // 20 kHz / 8192 = ~2,4 Hz
+  // gives enough headroom to transmit the reading at 19200 baud
+  // and allows to survive flashing display where there might be no digits
+  //  in a reading.
+  WDTCTL = WDT_UNLOCK | WDT_CLEAR | WDT_ACLK | WDT_8192;
+
+  if (!(warm_restart && config_valid(&config_))) {
+    config_ = config_load(&stored_config_);
+  }
+#if DECODER_TRACE > 0
+  // what the decoder saw before the reset, before it is overwritten
+  if (warm_restart && trace_valid(&trace_)) {
+    send_trace();
+  } else {
+    trace_clear(&trace_);
+  }
+#endif
+  struct si_average average = {0, 0U, false, {0, 0, SI_NONE}};
+  struct burst burst = {0U, 0U, 0U, 0U, 0U};
+  struct decoder_state state = {0U, 0};
+  for (bool first_reading = true;; first_reading = false) {
+    P1IFG = (u8)(P1IFG & ~Rx); // edges while not listening
+    P1IE = T | S | RX_IE;
+    while (state.next_digit <= NUMBER_OF_DIGITS) {
       go_to_sleep();
+      const unsigned input = capture_input();
+      const struct decoder_state next = decode(state, input);
+#if DECODER_TRACE > 0
+      trace_add(&trace_, trace_word(input, next));
+#endif
+      probe_low();
+#if TELEMETRY_INTERVAL > 0
+      if (telemetry_decoded(&telemetry_, state, next)) {
+        telemetry_period(&telemetry_, (u16)aclk_now());
+      }
+#endif
+      state = next;
     }
     P1IE = 0U;
+#if TELEMETRY_INTERVAL > 0
+    // the serial line may still be busy with a command or a triggered reading
+    if (sending_ != nullptr) {
+      telemetry_.overruns += 1U;
+    }
+#endif
+    sleep_while(receiving_ || sending_ != nullptr);
 
-    char text[MAX_READING_SIZE];
-    print_reading(text, state.reading);
+    // serviced once per reading, i.e. once per nT period
+    WDTCTL = WDT_UNLOCK | WDT_CLEAR | WDT_ACLK | WDT_8192;
 
-    send_serial(text);
+    const u32 now = fold_timer();
+
+    bool stored = false;
+    if (command_ready_) {
+      flush_burst(&burst);
+      struct config next = config_;
+      const char *answer = "#OK\r\n";
+      switch (execute_command(&next, command_, command_length_)) {
+      case COMMAND_ERROR:
+        answer = "#ERR\r\n";
+        break;
+      case COMMAND_TRIGGER:
+        trigger_ = true;
+        answer = "";
+        break;
+      case COMMAND_STATUS:
+        output_valid_ = false;
+        print_status_config(output_, &next);
+        send_serial(output_);
+        print_status_counters(output_, retained_.sequence, retained_.resets,
+                              command_errors_, trigger_latency_);
+        answer = output_;
+        break;
+      case COMMAND_STORE:
+        answer = store_config(&next) ? answer : "#ERR\r\n";
+        stored = true;
+        break;
+#if DECODER_TRACE > 0
+      case COMMAND_TRACE:
+        send_trace();
+        answer = "";
+        break;
+#endif
+      default:
+        break;
+      }
+      // the answer is sent at the baud rate the command was received with
+      send_serial(answer);
+      config_ = next;
+      command_length_ = 0U;
+      command_ready_ = false;
+    }
+
+    // a burst frame is built up in the output buffer
+    output_valid_ = output_valid_ && config_.format != FORMAT_BURST;
+    if (print_output(output_, &config_, &average, &burst, state.reading,
+                     state.next_digit == BLANK_PERIOD, retained_.sequence,
+                     now)) {
+      output_valid_ = true;
+      retained_.sequence += 1U;
+      retained_commit(&retained_);
+      if (trigger_) {
+        trigger_latency_ = (u16)(aclk_now() - trigger_time_);
+      }
+      if (trigger_ || !config_.triggered) {
+        trigger_ = false;
+        send_serial(output_);
+      }
+    }
+    // The CPU stalls while the flash is written, so the reading in progress
+    // is dropped.
+    state = stored ? (struct decoder_state){0U, 0} : decode_next(state);
+
+    if (first_reading && (warm_restart || STARTUP_REPORT)) {
+      flush_burst(&burst);
+      output_valid_ = false;
+      print_restart_report(output_, warm_restart, retained_.resets, now);
+      send_serial(output_);
+    }
+#if TELEMETRY_INTERVAL > 0
+    if (telemetry_.periods >= TELEMETRY_INTERVAL) {
+      flush_burst(&burst);
+      output_valid_ = false;
+      print_telemetry(output_, &telemetry_);
+      telemetry_restart(&telemetry_);
+      send_serial(output_);
+    }
+#endif
   }
 }
 
-static void send_serial(const char msg[static MAX_READING_SIZE]) {
-  // start timer for serial data clock
-  TACCR0 = (SMCLK_FREQUENCY / SERIAL_BAUD_RATE) / 2;
+// Switches the timer from counting ACLK to clocking the serial line.
+static void start_serial_clock(void) {
+  timestamp_ += TAR;
+  TACTL = TACTL_SMCLK | TACTL_CLEAR; // for best resolution of the baud rate
+  TACCR0 = half_bit_ticks_[config_.baud_rate];
   TACCTL0 = TACCTL0_OUTMODE_TOGGLE;
   TACTL_START(TACTL_UP);
+}
+
+static void stop_serial_clock(void) {
+  TACTL = TACTL_ACLK | TACTL_CLEAR | TACTL_CONTINUOUS;
+}
+
+// Starts shifting out the given character. The USI interrupt signals the end.
+static void send_char(const char c) {
+  USISR = (u16)(STOP_BIT | ((unsigned)c << 1U)); // space for the start bit
+  // extra start & stop bits as we're in SPI mode --v
+  USICNT = USI_16BIT | (SERIAL_DATA_BITS + 2);
+  timestamp_ += aclk_char_ticks_[config_.baud_rate];
+}
+
+// Shifts out the next character of the message, which includes the frame
+// check, if enabled. Returns true at the end of the message.
+static bool send_next_char(void) {
+  const char c = *sending_;
+  if (SERIAL_FRAME_CHECK && c == '\r' && trailer_ < FRAME_CHECK_SIZE) {
+    send_char(trailer_ == 0U   ? FRAME_CHECK_MARKER
+              : trailer_ == 1U ? hex_digit(frame_check_ >> 4U)
+                               : hex_digit(frame_check_));
+    trailer_ += 1U;
+    return false;
+  }
+  if (c == '\0') {
+    stop_serial_clock();
+    sending_ = nullptr;
+    return true;
+  }
+  send_char(c);
+  // the checksum is updated while the character is being shifted out, and
+  // covers a line, which may take several messages, as the status does
+  frame_check_ = c == '\n' ? 0U : frame_check_update(frame_check_, c);
+  trailer_ = c == '\n' ? 0U : trailer_;
+  sending_ = sending_ + 1;
+  return false;
+}
+
+// Starts sending the message in the background, see `on_usi()`. Commands
+// cannot be received meanwhile.
+static void start_sending(const char *msg) {
+  P1IE = (u8)(P1IE & ~Rx);
+  sending_ = msg;
 
   // configure serial output
   P1SEL |= Tx; // USI on P1.6
@@ -104,24 +406,131 @@ static void send_serial(const char msg[static MAX_READING_SIZE]) {
   }
   USICTL |= USI_IE;
 
-  for (int i = 0; i < MAX_READING_SIZE && msg[i] != '\0'; ++i) {
-    USISR = STOP_BIT | ((unsigned)msg[i] << 1U); // make space for the start bit
-    // extra start & stop bits as we're in SPI mode --v
-    USICNT = USI_16BIT | (SERIAL_DATA_BITS + 2);
-    go_to_sleep();
+  start_serial_clock();
+  send_next_char();
+}
+
+static void send_serial(const char *msg) {
+  if (*msg == '\0') {
+    return;
   }
+  start_sending(msg);
+  sleep_while(sending_ != nullptr);
+}
 
-  TACTL_STOP();
+// Writes the configuration to segment D of the information memory.
+static bool store_config(const struct config *c) {
+  // flash timing generator operation frequency must be in 257..476 kHz
+  FCTL2 = FLASH_KEY | FCTL2_SMCLK | FCTL2_DIVIDE_BY(40);
+  disable_interrupts();
+  FCTL3 = FLASH_KEY; // unlock, but leave segment A locked
+  FCTL1 = FLASH_KEY | FCTL1_ERASE;
+  stored_config_.magic = 0U; // erases the segment
+  FCTL1 = FLASH_KEY | FCTL1_WRITE;
+  stored_config_ = *c;
+  FCTL1 = FLASH_KEY;
+  FCTL3 = FLASH_KEY | FCTL3_LOCK;
+  enable_interrupts();
+  return (FCTL3 & FCTL3_FAIL) == 0U;
+}
+
+// Starts receiving a character at the falling edge of its start bit. Like
+// when sending, the USI is clocked by the timer, and it samples the middle of
+// each bit without the CPU, which is only needed again at the end, see
+// `finish_receive()`.
+static void start_receive(void) {
+  receiving_ = true;
+  P1IE = (u8)(P1IE & ~Rx);
+
+  P1SEL |= Tx | Rx; // USI on P1.6 & P1.7
+  USICCTL = USI_TACCR0;
+  USICTL = USI_PE7 | USI_PE6 | USI_LSB | USI_MASTER | USI_OE | USI_RESET;
+  USISR = 0xffffU; // keeps Tx high while shifting
+  // the first edge of the clock is half a bit after the start of the start bit
+  USICTL = USI_CKPH | USI_IE | USI_PE7 | USI_PE6 | USI_LSB | USI_MASTER |
+           USI_OE;
+  //        start & stop bits --v
+  USICNT = USI_16BIT | (SERIAL_DATA_BITS + 2);
+  start_serial_clock();
+}
+
+// Appends the received character to the command, unless it is corrupted, or
+// answers a trigger.
+static void finish_receive(void) {
+  stop_serial_clock();
+  // the bits have been shifted in from the top, LSB first
+  const unsigned frame = USISR >> (16U - (SERIAL_DATA_BITS + 2));
+  P1SEL = (u8)(P1SEL & ~Rx);
+  timestamp_ += aclk_char_ticks_[config_.baud_rate];
+  receiving_ = false;
+  P1IFG = (u8)(P1IFG & ~Rx); // the edges of this character
+
+  u8 length = command_length_;
+  const char c = (char)((frame >> 1U) & 0x7fU);
+  const bool valid = (frame & (STOP_BIT | 1U)) == STOP_BIT;
+  if (valid && c == TRIGGER_CHAR && length == 0U) {
+    // answered with the latest reading right away, if there is one
+    trigger_time_ = timestamp_;
+    if (output_valid_) {
+      trigger_latency_ = 0U;
+      start_sending(output_);
+      return;
+    }
+    trigger_ = true;
+  } else if (command_ready_) {
+    command_errors_ += 1U; // the previous command has not been executed yet
+  } else if (!valid) {
+    // drop the command up to the end of the line
+    length = MAX_COMMAND_SIZE + 1U;
+    command_errors_ += 1U;
+  } else if (c == '\r' || c == '\n') {
+    if (length > MAX_COMMAND_SIZE) {
+      length = 0U;
+    } else if (length > 0U) {
+      trigger_time_ = timestamp_;
+      command_ready_ = true;
+    }
+  } else if (length < MAX_COMMAND_SIZE) {
+    command_[length++] = c;
+  } else if (length == MAX_COMMAND_SIZE) {
+    length = MAX_COMMAND_SIZE + 1U;
+    command_errors_ += 1U;
+  }
+  command_length_ = length;
+
+  if (P1IE & T) {
+    P1IE |= RX_IE; // still decoding
+  }
 }
 
 __attribute__((interrupt)) void on_port1(void) {
+  probe_high();
+  const u8 flags = P1IFG;
   P1IFG = 0U;
-  stay_awake();
+  if (flags & P1IE & Rx) {
+    start_receive();
+  }
+  // only strobes and nT wake the decoder
+  if (flags & (T | S)) {
+    stay_awake();
+  }
 }
 
 __attribute__((interrupt)) void on_usi(void) {
-  USICTL &= ~USI_IFG;
-  stay_awake();
+  probe_high();
+  USICTL = (u16)(USICTL & ~USI_IFG);
+  if (receiving_) {
+    finish_receive();
+    if (sending_ == nullptr && (P1IE & T) == 0U) {
+      stay_awake(); // the command is in, while `main()` waits for it
+    }
+  } else if (send_next_char() && (P1IE & T) == 0U) {
+    stay_awake(); // the message is out
+  } else if (sending_ == nullptr) {
+    P1IFG = (u8)(P1IFG & ~Rx);
+    P1IE |= RX_IE; // still decoding
+  }
+  probe_low();
 }
 
 __attribute__((used, section(".vectors"))) static const struct vtable vt = {
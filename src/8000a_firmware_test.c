@@ -0,0 +1,150 @@
+// Runs the 8000A firmware on the simulated MCU, see `msp430/mcu_sim.c`, with
+// the simulated bus, and checks what it sends. It is built with all formats,
+// and as for the G2231, which leaves some out.
+
+#define MSP430_SIM
+
+#include "8000a_firmware.c"
+#include "8000a_sim.c"
+
+#undef main
+
+#include <unity.h>
+
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const struct mcu_board board_ = {&vt, Tx, SERIAL_BAUD_RATE, 0U, 0U};
+
+static struct sim sim_;
+static struct mcu_edge edges_[SIM_MAX_TICKS + 64U];
+
+// Simulates periods that show 123, followed by the given time of idle bus.
+static size_t simulate(const int periods, const uint64_t idle_us) {
+  static const unsigned digits[] = {0x6U, 0x1U, 0x2U, 0x3U};
+  sim_.length = 0U;
+  for (int i = 0; i < periods; ++i) {
+    sim_period(&sim_, digits);
+  }
+  size_t length = sim_edges(&sim_, edges_);
+  edges_[length] = edges_[length - 1U];
+  edges_[length++].time += idle_us;
+  return length;
+}
+
+// Inserts the characters as received on Rx from the given time on.
+static size_t receive(size_t length, uint64_t time, const char *text) {
+  const uint64_t bit_us = 1000000U / SERIAL_BAUD_RATE;
+  for (; *text != '\0'; ++text) {
+    const unsigned frame = STOP_BIT | (unsigned)*text << 1U;
+    for (int bit = 0; bit < SERIAL_DATA_BITS + 2; ++bit, time += bit_us) {
+      size_t i = length;
+      for (; i > 0U && edges_[i - 1U].time > time; --i) {
+      }
+      memmove(&edges_[i + 1U], &edges_[i], (length - i) * sizeof edges_[0]);
+      length += 1U;
+      edges_[i] = edges_[i - 1U];
+      edges_[i].time = time;
+      for (size_t k = i; k < length; ++k) {
+        const u8 level = (frame >> bit & 1U) != 0U ? Rx : 0U;
+        edges_[k].port1 = (u8)((edges_[k].port1 & ~Rx) | level);
+      }
+    }
+  }
+  return length;
+}
+
+void test_readings(void) {
+  const size_t length = simulate(3, 100000U);
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, length));
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n + 123\r\n + 123\r\n", mcu_.output);
+  // woken by the strobes, both edges of T, and at the end of the message, but
+  // the bus starts with T high
+  TEST_ASSERT_EQUAL_UINT32(3U * 7U - 1U, mcu_.wakeups);
+}
+
+void test_status_command(void) {
+  // while the strobes of the second period are captured
+  size_t length = simulate(3, 100000U);
+  length = receive(length, 1000U * (SIM_PERIOD_TICKS + SIM_UPDATE_TICKS + 2U),
+                   "S\r");
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, length));
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n"
+                           "#S 0 19200 0 0 16 0 1 0 0 0\r\n"
+                           " + 123\r\n + 123\r\n",
+                           mcu_.output);
+}
+
+void test_burst_format_if_built(void) {
+  size_t length = simulate(2, 100000U);
+  length = receive(length, 1000U * SIM_PERIOD_TICKS, "F3\r");
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, length));
+  // the frame of the next reading is not complete yet
+  TEST_ASSERT_EQUAL_STRING(BURST_FORMAT ? " + 123\r\n#OK\r\n"
+                                        : " + 123\r\n#ERR\r\n + 123\r\n",
+                           mcu_.output);
+}
+
+void test_si_formats_if_built(void) {
+  size_t length = simulate(2, 100000U);
+  length = receive(length, 1000U * SIM_PERIOD_TICKS, "F2\r");
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, length));
+  TEST_ASSERT_EQUAL_STRING(SI_FORMATS ? " + 123\r\n#OK\r\n+1.23E+02\r\n"
+                                      : " + 123\r\n#ERR\r\n + 123\r\n",
+                           mcu_.output);
+}
+
+void test_watchdog_reset(void) {
+  // no readings for a while
+  const size_t length = simulate(1, 2000000U);
+  TEST_ASSERT_EQUAL_INT(MCU_WATCHDOG, mcu_run(&board_, edges_, length));
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n", mcu_.output);
+  // 8192 ticks of ACLK after the reading
+  TEST_ASSERT_UINT32_WITHIN(10U, 1000U * sim_strobe_tick(0U, 3) + 682667U,
+                            (u32)(mcu_.now / MCU_TICKS_PER_US));
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board_, edges_, simulate(1, 100000U)));
+  // the time since the reset is off, as the variables are not initialized again
+  TEST_ASSERT_EQUAL_STRING_LEN(" + 123\r\n#WDT 1 ", mcu_.output, 15U);
+}
+
+void test_settings_survive_watchdog_reset(void) {
+  // not stored, and no readings for a while after the command
+  size_t length = simulate(3, 2000000U);
+  length = receive(length, 1000U * (SIM_PERIOD_TICKS + SIM_UPDATE_TICKS + 2U),
+                   "M1\r");
+  TEST_ASSERT_EQUAL_INT(MCU_WATCHDOG, mcu_run(&board_, edges_, length));
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n#OK\r\n", mcu_.output);
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board_, edges_, simulate(1, 100000U)));
+  // still triggered, so the reading is not sent
+  TEST_ASSERT_EQUAL_STRING_LEN("#WDT 1 ", mcu_.output, 7U);
+  TEST_ASSERT_NULL(strstr(mcu_.output, " + 123"));
+}
+
+void test_timestamp_while_triggered(void) {
+  // nothing is sent for longer than the timer takes to wrap, 65536 ticks of
+  // ACLK, in triggered mode
+  size_t length = simulate(60, 100000U);
+  length = receive(length, 1000U * SIM_PERIOD_TICKS, "M1\r");
+  timestamp_ = 0U; // not initialized again by the simulation
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, length));
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n#OK\r\n", mcu_.output);
+  const u32 aclk = (u32)(mcu_.now / mcu_clock_ticks(true));
+  TEST_ASSERT_GREATER_THAN_UINT32(65536U, aclk);
+  TEST_ASSERT_UINT32_WITHIN(aclk / 100U, aclk, aclk_now());
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings);
+  RUN_TEST(test_status_command);
+  RUN_TEST(test_burst_format_if_built);
+  RUN_TEST(test_si_formats_if_built);
+  RUN_TEST(test_watchdog_reset);
+  RUN_TEST(test_settings_survive_watchdog_reset);
+  RUN_TEST(test_timestamp_while_triggered);
+  return UNITY_END();
+}
@@ -0,0 +1,29 @@
+// Pin assignment of the 8000A DOU and the mapping of the port states to the
+// inputs of the decoder.
+
+#include "8000a.c"
+
+// Masks for the I/O ports.
+enum port1 {  // pin  | function
+  Z = 0x01U,  // P1.0 | BCD 1 ╮
+  Y = 0x02U,  // P1.1 | BCD 2 ├ digit
+  X = 0x04U,  // P1.2 | BCD 4 │
+  W = 0x08U,  // P1.3 | BCD 8 ╯
+  T = 0x10U,  // P1.4 | inverted nT with fixed logic levels
+  S = 0x20U,  // P1.5 | strobe clock
+  Tx = 0x40U, // P1.6 | SDO
+  Rx = 0x80U, // P1.7 | SDI, commands from the host
+};
+enum port2 {  // pin       | function
+  S1 = 0x40U, // P2.6/XIN  | MSD (DS1) strobe
+  S4 = 0x80U, // P2.7/XOUT | LSD (DS4) strobe
+};
+
+// As the pins are assigned to match the inputs bit by bit, this compiles to
+// two masks. A table, as for the 1900A, would not fit the G2231's flash.
+static unsigned remap_ports(const u8 port1, const u8 port2) {
+  return REMAP_PIN(port1, Z, INPUT_Z) | REMAP_PIN(port1, Y, INPUT_Y) |
+         REMAP_PIN(port1, X, INPUT_X) | REMAP_PIN(port1, W, INPUT_W) |
+         REMAP_PIN(port1, T, INPUT_T) | REMAP_PIN(port1, S, INPUT_S) |
+         REMAP_PIN(port2, S1, INPUT_S1) | REMAP_PIN(port2, S4, INPUT_S4);
+}
@@ -0,0 +1,93 @@
+// Simulates the signals of the 8000A bus as seen by the decoder, i.e. as
+// `INPUT_*` words, one per tick, for tests of the capture path.
+//
+// A period starts with T high for `SIM_UPDATE_TICKS`, while the meter is busy.
+// With T low, the digits are strobed in the order S1, S3, S2, S4, each one with
+// a low pulse of S, which is captured with its rising edge.
+
+// The firmware brings the decoder along, when it runs on the simulated MCU.
+#ifndef MSP430_SIM
+#include "8000a_ports.c"
+#endif
+
+#include <stddef.h>
+
+#define SIM_UPDATE_TICKS 40
+#define SIM_SETUP_TICKS  4  // digit and strobe before S goes low
+#define SIM_LOW_TICKS    4  // of S
+#define SIM_HOLD_TICKS   12 // digit and strobe after S went high
+#define SIM_DIGIT_TICKS  (SIM_SETUP_TICKS + SIM_LOW_TICKS + SIM_HOLD_TICKS)
+#define SIM_PERIOD_TICKS (SIM_UPDATE_TICKS + 4 * SIM_DIGIT_TICKS + 4)
+#define SIM_MAX_TICKS    (64 * SIM_PERIOD_TICKS)
+
+struct sim {
+  unsigned inputs[SIM_MAX_TICKS];
+  size_t length;
+};
+
+static void sim_append(struct sim *sim, const unsigned input, int ticks) {
+  for (; ticks > 0 && sim->length < SIM_MAX_TICKS; --ticks) {
+    sim->inputs[sim->length++] = input;
+  }
+}
+
+// Appends a period that strobes the given MSD, 2SD, 3SD and LSD, or nothing,
+// like the flashing display during overload.
+static void sim_period(struct sim *sim, const unsigned *digits) {
+  sim_append(sim, INPUT_T | INPUT_S, SIM_UPDATE_TICKS);
+  if (digits != nullptr) {
+    // strobes, and the index of the digit they carry
+    static const struct {
+      unsigned strobe;
+      int digit;
+    } order[4] = {{INPUT_S1, 0}, {0U, 2}, {0U, 1}, {INPUT_S4, 3}};
+    for (int i = 0; i < 4; ++i) {
+      const unsigned input = order[i].strobe | digits[order[i].digit];
+      sim_append(sim, INPUT_S | input, SIM_SETUP_TICKS);
+      sim_append(sim, input, SIM_LOW_TICKS);
+      sim_append(sim, INPUT_S | input, SIM_HOLD_TICKS);
+    }
+  } else {
+    sim_append(sim, INPUT_S, 4 * SIM_DIGIT_TICKS);
+  }
+  sim_append(sim, INPUT_S, 4);
+}
+
+// Pulls S low for `width` ticks, starting at `tick`.
+static void sim_glitch(struct sim *sim, const size_t tick, const int width) {
+  for (size_t t = tick; t < tick + (size_t)width && t < sim->length; ++t) {
+    sim->inputs[t] &= ~(unsigned)INPUT_S;
+  }
+}
+
+// Returns the tick at which S rises for the given strobe (0 = S1, 1 = S3,
+// 2 = S2, 3 = S4) of the period starting at `period_start`.
+static size_t sim_strobe_tick(const size_t period_start, const int strobe) {
+  return period_start + SIM_UPDATE_TICKS +
+         (size_t)strobe * SIM_DIGIT_TICKS + SIM_SETUP_TICKS + SIM_LOW_TICKS;
+}
+
+#ifdef MSP430_SIM
+// Converts the simulated inputs to the edges of the ports of the simulated MCU,
+// see `mcu_sim.c`, with one tick per ms and Rx idle. Returns their number.
+static size_t sim_edges(const struct sim *sim, struct mcu_edge *edges) {
+  size_t length = 0U;
+  for (size_t i = 0U; i < sim->length; ++i) {
+    u8 port1 = Rx;
+    u8 port2 = 0U;
+    for (unsigned pin = 1U; pin <= 0x80U; pin <<= 1U) {
+      if ((remap_ports((u8)pin, 0U) & sim->inputs[i]) != 0U) {
+        port1 = (u8)(port1 | pin);
+      }
+      if ((remap_ports(0U, (u8)pin) & sim->inputs[i]) != 0U) {
+        port2 = (u8)(port2 | pin);
+      }
+    }
+    if (length == 0U || edges[length - 1U].port1 != port1 ||
+        edges[length - 1U].port2 != port2) {
+      edges[length++] = (struct mcu_edge){1000U * i, port1, port2};
+    }
+  }
+  return length;
+}
+#endif
@@ -1,9 +1,15 @@
 // Tests whether the calculation of checksums is correct.
 
-#include "8000a.c"
+#define GLITCH_FILTER_SAMPLES 5
+#define DECODER_TRACE         4
+
+#include "8000a_sim.c"
 
 #include <unity.h>
 
+#include <stdio.h>
+#include <string.h>
+
 void setUp(void) {}
 void tearDown(void) {}
 
@@ -53,33 +59,549 @@ void test_decode(void) {
   TEST_ASSERT_EQUAL_UINT(0xf731U, state.reading);
 }
 
+void test_decode_in_progress(void) {
+  // After a reset, a period that is already in progress is decoded, as long
+  // as S1 is still to come ...
+  struct decoder_state state = {0U, 0};
+  state = decode(state, INPUT_S | INPUT_S1 | INPUT_Y | INPUT_Z);
+  TEST_ASSERT_EQUAL_INT(1, state.next_digit);
+  state = decode(state, INPUT_S | INPUT_S1 | INPUT_Y | INPUT_Z);
+  state = decode(state, INPUT_S | INPUT_Z);
+  state = decode(state, INPUT_S | INPUT_Y);
+  state = decode(state, INPUT_S | INPUT_S4 | INPUT_X);
+  TEST_ASSERT_EQUAL_INT(5, state.next_digit);
+  TEST_ASSERT_EQUAL_UINT(0x3124U, state.reading);
+
+  // ... or else, the decoder waits for the next period.
+  state = (struct decoder_state){0U, 0};
+  state = decode(state, INPUT_S | INPUT_Y);
+  state = decode(state, INPUT_S | INPUT_S4 | INPUT_X);
+  TEST_ASSERT_EQUAL_INT(1, state.next_digit);
+  state = decode(state, INPUT_T);
+  TEST_ASSERT_EQUAL_INT(0, state.next_digit);
+}
+
+// Generates the inputs of one nT period, strobing the given MSD, 2SD, 3SD and
+// LSD, or nothing, like the flashing display during overload.
+static unsigned *generate_period(unsigned *inputs, const unsigned *digits) {
+  *inputs++ = INPUT_T | INPUT_S;
+  *inputs++ = INPUT_T | INPUT_S;
+  *inputs++ = INPUT_S;
+  if (digits != 0) {
+    *inputs++ = INPUT_S | INPUT_S1 | digits[0];
+    *inputs++ = INPUT_S | digits[2]; // S3
+    *inputs++ = INPUT_S | digits[1]; // S2
+    *inputs++ = INPUT_S | INPUT_S4 | digits[3];
+  }
+  *inputs++ = INPUT_S;
+  return inputs;
+}
+
+// Runs the decoder like the firmware does and prints each reading to `text`.
+static void run_decoder(const unsigned *inputs, const unsigned *end,
+                        char *text) {
+  struct decoder_state state = {0U, 0};
+  for (; inputs != end; ++inputs) {
+    state = decode(state, *inputs);
+    if (state.next_digit > NUMBER_OF_DIGITS) {
+      text = print_reading(text, state.reading,
+                           state.next_digit == BLANK_PERIOD);
+      state = decode_next(state);
+    }
+  }
+}
+
+void test_decode_overload_flashing(void) {
+  static const unsigned normal[] = {0x6U, 0x1U, 0x2U, 0x3U};
+  static const unsigned overload[] = {0xbU, 0x9U, 0x9U, 0x9U};
+  unsigned inputs[64];
+  unsigned *end = inputs;
+  end = generate_period(end, normal);
+  end = generate_period(end, 0);
+  end = generate_period(end, overload);
+  end = generate_period(end, 0);
+  end = generate_period(end, overload);
+  end = generate_period(end, 0);
+  end = generate_period(end, normal);
+  end = generate_period(end, 0);
+  end = generate_period(end, 0);
+
+  char text[8U * MAX_READING_SIZE];
+  run_decoder(inputs, end, text);
+  // blank periods are skipped, unless they follow an overload reading
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n"
+                           ">+1999\r\n"
+                           "=+1999\r\n"
+                           ">+1999\r\n"
+                           "=+1999\r\n"
+                           " + 123\r\n",
+                           text);
+}
+
+void test_decode_overload_held(void) {
+  static const unsigned overload[] = {0xaU, 0x0U, 0x0U, 0x0U};
+  unsigned inputs[64];
+  unsigned *end = inputs;
+  end = generate_period(end, overload);
+  // a glitch aborts the period, which must not be mistaken for a blank one
+  *end++ = INPUT_T | INPUT_S;
+  *end++ = INPUT_S;
+  *end++ = INPUT_S | INPUT_S1 | 0xaU;
+  *end++ = INPUT_S | INPUT_S4;
+  *end++ = INPUT_S;
+  end = generate_period(end, 0);
+  end = generate_period(end, 0);
+
+  char text[8U * MAX_READING_SIZE];
+  run_decoder(inputs, end, text);
+  TEST_ASSERT_EQUAL_STRING(">+ 000\r\n", text);
+}
+
+void test_decode_overload_blank(void) {
+  static const unsigned overload[] = {0xbU, 0x9U, 0x9U, 0x9U};
+  unsigned inputs[64];
+  unsigned *end = inputs;
+  end = generate_period(end, overload);
+  end = generate_period(end, 0);
+  end = generate_period(end, 0);
+  end = generate_period(end, 0);
+
+  char text[8U * MAX_READING_SIZE];
+  run_decoder(inputs, end, text);
+  // only the first blank period repeats the overload reading
+  TEST_ASSERT_EQUAL_STRING(">+1999\r\n"
+                           "=+1999\r\n",
+                           text);
+}
+
+static struct telemetry telemetry_;
+
+// Captures the simulated inputs like the firmware does, i.e. on each edge of T
+// and on each rising edge of S or, with the glitch filter, on each edge of S
+// away from the filtered level. Prints the readings to `text` and keeps the
+// `telemetry_` with ticks for time.
+static void run_capture(const struct sim *sim, const bool filter,
+                        char *text) {
+  telemetry_ = (struct telemetry){0};
+  struct decoder_state state = {0U, 0};
+  bool level = false;
+  bool pending = false; // an edge during sampling set the interrupt flag
+  *text = '\0';
+  const size_t num_samples = GLITCH_FILTER_SAMPLES;
+  for (size_t t = 1U; t + num_samples <= sim->length; ++t) {
+    const unsigned changes = sim->inputs[t] ^ sim->inputs[t - 1U];
+    const bool s = (sim->inputs[t] & INPUT_S) != 0U;
+    const bool t_edge = (changes & INPUT_T) != 0U;
+    const bool s_edge = (changes & INPUT_S) != 0U;
+    unsigned input = sim->inputs[t];
+    if (!filter) {
+      if (!t_edge && !(s_edge && s)) {
+        continue;
+      }
+    } else {
+      if (!t_edge && (s == level || !(s_edge || pending))) {
+        continue;
+      }
+      input = filter_strobe(&level, &telemetry_.glitches, &sim->inputs[t]);
+      t += num_samples - 1U;
+      pending = ((sim->inputs[t] & INPUT_S) != 0U) != level;
+    }
+    const struct decoder_state next = decode(state, input);
+    if (telemetry_decoded(&telemetry_, state, next)) {
+      telemetry_period(&telemetry_, (u16)t);
+    }
+    state = next;
+    if (state.next_digit > NUMBER_OF_DIGITS) {
+      text = print_reading(text, state.reading,
+                           state.next_digit == BLANK_PERIOD);
+      state = decode_next(state);
+    }
+  }
+}
+
+static struct sim sim_;
+
+#define SIMULATED_READINGS " + 123\r\n + 123\r\n + 123\r\n"
+
+// Simulates three periods with a glitch of the given width in the high phase
+// of S after the given strobe, past the sampling window of the rising edge.
+static void simulate_readings(const int glitch_strobe, const int width) {
+  static const unsigned digits[] = {0x6U, 0x1U, 0x2U, 0x3U};
+  sim_.length = 0U;
+  for (int i = 0; i < 3; ++i) {
+    const size_t start = sim_.length;
+    sim_period(&sim_, digits);
+    if (width > 0) {
+      sim_glitch(&sim_, sim_strobe_tick(start, glitch_strobe) + 6U, width);
+    }
+  }
+}
+
+void test_capture_without_glitches(void) {
+  char text[8U * MAX_READING_SIZE];
+  simulate_readings(0, 0);
+  run_capture(&sim_, false, text);
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, text);
+  run_capture(&sim_, true, text);
+  TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, text);
+}
+
+void test_capture_glitches_on_s1_and_s4(void) {
+  // the decoder itself copes with the systematic glitches of the 8000A
+  char text[8U * MAX_READING_SIZE];
+  for (int width = 1; width <= SIM_HOLD_TICKS - 7; ++width) {
+    simulate_readings(0, width);
+    run_capture(&sim_, false, text);
+    TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, text);
+    simulate_readings(3, width);
+    run_capture(&sim_, false, text);
+    TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, text);
+    run_capture(&sim_, true, text);
+    TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, text);
+  }
+}
+
+void test_capture_overload_flashing(void) {
+  // the blank periods are told apart by the edges of T alone
+  static const unsigned overload[] = {0xbU, 0x9U, 0x9U, 0x9U};
+  sim_.length = 0U;
+  sim_period(&sim_, overload);
+  sim_period(&sim_, nullptr);
+  sim_period(&sim_, overload);
+  sim_period(&sim_, nullptr);
+  sim_append(&sim_, INPUT_T | INPUT_S, SIM_UPDATE_TICKS);
+
+  char text[8U * MAX_READING_SIZE];
+  for (int filter = 0; filter <= 1; ++filter) {
+    run_capture(&sim_, filter, text);
+    TEST_ASSERT_EQUAL_STRING(">+1999\r\n=+1999\r\n>+1999\r\n=+1999\r\n", text);
+  }
+}
+
+void test_capture_glitches_on_s3(void) {
+  // Without filter, a glitch after S3 is taken for the 2SD. Glitches shorter
+  // than half the sampling window are filtered out ...
+  char text[8U * MAX_READING_SIZE];
+  for (int width = 1; 2 * width < GLITCH_FILTER_SAMPLES; ++width) {
+    simulate_readings(1, width);
+    run_capture(&sim_, false, text);
+    TEST_ASSERT_NOT_EQUAL(0, strcmp(SIMULATED_READINGS, text));
+    run_capture(&sim_, true, text);
+    TEST_ASSERT_EQUAL_STRING(SIMULATED_READINGS, text);
+  }
+  // ... while longer ones pass as another edge.
+  simulate_readings(1, GLITCH_FILTER_SAMPLES);
+  run_capture(&sim_, true, text);
+  TEST_ASSERT_NOT_EQUAL(0, strcmp(SIMULATED_READINGS, text));
+}
+
+void test_telemetry(void) {
+  static const unsigned digits[] = {0x6U, 0x1U, 0x2U, 0x3U};
+  sim_.length = 0U;
+  sim_period(&sim_, digits);
+  // a period without strobes, the display is not flashing
+  sim_period(&sim_, nullptr);
+  // a period that ends after two strobes
+  const size_t start = sim_.length;
+  sim_period(&sim_, digits);
+  sim_.length = sim_strobe_tick(start, 2) - SIM_LOW_TICKS - SIM_SETUP_TICKS;
+  sim_append(&sim_, INPUT_S, 12);
+  sim_period(&sim_, digits);
+  sim_glitch(&sim_, sim_strobe_tick(sim_.length - SIM_PERIOD_TICKS, 1) + 6U,
+             1);
+  sim_append(&sim_, INPUT_T | INPUT_S, SIM_UPDATE_TICKS);
+
+  char text[8U * MAX_READING_SIZE];
+  run_capture(&sim_, true, text);
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n + 123\r\n", text);
+  TEST_ASSERT_EQUAL_UINT16(1U, telemetry_.aborted);
+  TEST_ASSERT_EQUAL_UINT16(1U, telemetry_.missed);
+  TEST_ASSERT_EQUAL_UINT16(1U, telemetry_.glitches);
+  TEST_ASSERT_EQUAL_UINT8(3U, telemetry_.periods);
+
+  char buffer[MAX_TELEMETRY_SIZE];
+  const unsigned short_period = SIM_UPDATE_TICKS + 2U * SIM_DIGIT_TICKS + 12U;
+  char expected[MAX_TELEMETRY_SIZE];
+  snprintf(expected, sizeof expected, "#H 1 1 1 0 %u %u %u\r\n", short_period,
+           (2U * SIM_PERIOD_TICKS + short_period) / 3U, SIM_PERIOD_TICKS);
+  print_telemetry(buffer, &telemetry_);
+  TEST_ASSERT_EQUAL_STRING(expected, buffer);
+
+  telemetry_.aborted = 65535U;
+  telemetry_.missed = 65535U;
+  telemetry_.glitches = 65535U;
+  telemetry_.overruns = 65535U;
+  telemetry_restart(&telemetry_);
+  print_telemetry(buffer, &telemetry_);
+  TEST_ASSERT_EQUAL_STRING("#H 65535 65535 65535 65535 0 0 0\r\n", buffer);
+}
+
 void test_print_reading(void) {
   char buffer[MAX_READING_SIZE];
-  print_reading(buffer, 0x0000U);
+  print_reading(buffer, 0x0000U, false);
   TEST_ASSERT_EQUAL_STRING(" - 000\r\n", buffer);
 
-  print_reading(buffer, 0x2000U);
+  print_reading(buffer, 0x2000U, false);
   TEST_ASSERT_EQUAL_STRING(" + 000\r\n", buffer);
 
-  print_reading(buffer, 0x6000U);
+  print_reading(buffer, 0x6000U, false);
   TEST_ASSERT_EQUAL_STRING(" + 000\r\n", buffer);
 
-  print_reading(buffer, 0x7000U);
+  print_reading(buffer, 0x7000U, false);
   TEST_ASSERT_EQUAL_STRING(" +1000\r\n", buffer);
 
-  print_reading(buffer, 0x6001U);
+  print_reading(buffer, 0x6001U, false);
   TEST_ASSERT_EQUAL_STRING(" + 001\r\n", buffer);
 
-  print_reading(buffer, 0x6010U);
+  print_reading(buffer, 0x6010U, false);
   TEST_ASSERT_EQUAL_STRING(" + 100\r\n", buffer);
 
-  print_reading(buffer, 0x6100U);
+  print_reading(buffer, 0x6100U, false);
   TEST_ASSERT_EQUAL_STRING(" + 010\r\n", buffer);
+
+  print_reading(buffer, 0xb999U, true);
+  TEST_ASSERT_EQUAL_STRING("=+1999\r\n", buffer);
+}
+
+void test_print_output(void) {
+  char buffer[MAX_OUTPUT_SIZE];
+  struct config config = {CONFIG_MAGIC, FORMAT_FIXED, 1U, 0U,
+                          0U,           BURST_SIZE,   0U, 0U};
+  struct si_average average = {0, 0U, false, {0, 0, SI_NONE}};
+  struct burst burst = {0U, 0U, 0U, 0U, 0U};
+  TEST_ASSERT_TRUE(print_output(buffer, &config, &average, &burst, 0x7123U,
+                                false, 0U, 0U));
+  TEST_ASSERT_EQUAL_STRING(" +1213\r\n", buffer);
+
+  config.format = FORMAT_CSV;
+  print_output(buffer, &config, &average, &burst, 0x7123U, false, 42U,
+               123456U);
+  TEST_ASSERT_EQUAL_STRING("42,123456,+1.213E+03,\r\n", buffer);
+  print_output(buffer, &config, &average, &burst, 0xb999U, true, 65535U,
+               0xffffffffU);
+  TEST_ASSERT_EQUAL_STRING("65535,4294967295,+9.9E+37,\r\n", buffer);
+
+  config.format = FORMAT_SCPI;
+  print_output(buffer, &config, &average, &burst, 0x0987U, false, 0U, 0U);
+  TEST_ASSERT_EQUAL_STRING("-8.97E+02\r\n", buffer);
+  print_output(buffer, &config, &average, &burst, 0x0000U, false, 0U, 0U);
+  TEST_ASSERT_EQUAL_STRING("+0E+00\r\n", buffer);
+  print_output(buffer, &config, &average, &burst, 0x60a0U, false, 0U, 0U);
+  TEST_ASSERT_EQUAL_STRING("+9.91E+37\r\n", buffer);
+
+  // " +1213" and " +1216" average to 1214
+  config.averaging = 1U;
+  TEST_ASSERT_FALSE(print_output(buffer, &config, &average, &burst, 0x7123U,
+                                 false, 0U, 0U));
+  TEST_ASSERT_TRUE(print_output(buffer, &config, &average, &burst, 0x7126U,
+                                false, 0U, 0U));
+  TEST_ASSERT_EQUAL_STRING("+1.214E+03\r\n", buffer);
+
+  // the held flag is packed above the digits
+  config.format = FORMAT_BURST;
+  TEST_ASSERT_FALSE(print_output(buffer, &config, &average, &burst, 0xb999U,
+                                 false, 3U, 100U));
+  burst_finish(buffer, &burst);
+  TEST_ASSERT_EQUAL_STRING("#D3 T3 i\\^1 0\r\n", buffer);
+  TEST_ASSERT_FALSE(print_output(buffer, &config, &average, &burst, 0xb999U,
+                                 true, 4U, 200U));
+  TEST_ASSERT_EQUAL_HEX32(0x1b999U, burst.previous);
+  burst_finish(buffer, &burst);
+
+  // at most N readings
+  config.burst_size = 2U;
+  TEST_ASSERT_FALSE(print_output(buffer, &config, &average, &burst, 0x1000U,
+                                 false, 5U, 0U));
+  TEST_ASSERT_TRUE(print_output(buffer, &config, &average, &burst, 0x1001U,
+                                false, 5U, 1920U));
+
+  // a period of 1920 ticks, so that the 4th reading is the last before 0.5 s
+  config.burst_size = BURST_SIZE;
+  config.burst_deadline = 5U;
+  for (u32 i = 0U; i < 3U; ++i) {
+    TEST_ASSERT_FALSE(print_output(buffer, &config, &average, &burst, 0x1000U,
+                                   false, 6U, i * 1920U));
+  }
+  TEST_ASSERT_TRUE(print_output(buffer, &config, &average, &burst, 0x1000U,
+                                false, 6U, 3U * 1920U));
+  TEST_ASSERT_EQUAL_UINT32(3U * 1920U, burst.span);
+}
+
+void test_reading_to_si(void) {
+  struct si_value value = reading_to_si(0x0000U);
+  TEST_ASSERT_EQUAL_INT32(0, value.value);
+  TEST_ASSERT_EQUAL_UINT8(SI_NONE, value.unit);
+
+  value = reading_to_si(0x7123U); // " +1213"
+  TEST_ASSERT_EQUAL_INT32(1213, value.value);
+  TEST_ASSERT_EQUAL_INT8(0, value.exponent);
+
+  value = reading_to_si(0x0987U); // " - 897"
+  TEST_ASSERT_EQUAL_INT32(-897, value.value);
+
+  value = reading_to_si(0x60a0U);
+  TEST_ASSERT_EQUAL_UINT8(SI_INVALID, value.unit);
+}
+
+void test_restart_report(void) {
+  char buffer[MAX_REPORT_SIZE];
+  print_restart_report(buffer, false, 0U, 7U);
+  TEST_ASSERT_EQUAL_STRING("#POR 0 7\r\n", buffer);
+  print_restart_report(buffer, true, 65535U, 1024U);
+  TEST_ASSERT_EQUAL_STRING("#WDT 65535 1024\r\n", buffer);
+}
+
+void test_retained(void) {
+  struct retained r = {0U, 0U, 0U};
+  TEST_ASSERT_FALSE(retained_valid(&r));
+  retained_commit(&r);
+  TEST_ASSERT_TRUE(retained_valid(&r));
+  r.resets += 1U;
+  TEST_ASSERT_FALSE(retained_valid(&r));
+}
+
+void test_trace(void) {
+  struct trace t = {{0U}, 1U, 0U, 0U};
+  TEST_ASSERT_FALSE(trace_valid(&t));
+  trace_clear(&t);
+  TEST_ASSERT_TRUE(trace_valid(&t));
+  TEST_ASSERT_EQUAL_UINT16(0U, t.count);
+  for (u32 i = 1U; i <= 6U; ++i) {
+    trace_add(&t, i);
+  }
+  TEST_ASSERT_TRUE(trace_valid(&t));
+  // the oldest ones are overwritten
+  TEST_ASSERT_EQUAL_UINT16(4U, t.count);
+  TEST_ASSERT_EQUAL_UINT32(3U, trace_at(&t, 0U));
+  TEST_ASSERT_EQUAL_UINT32(6U, trace_at(&t, 3U));
+
+  const struct decoder_state state = {0x123U, 2};
+  TEST_ASSERT_EQUAL_HEX32(0x10020123U, trace_word(INPUT_T, state));
+  const struct decoder_state period_end = {0U, PERIOD_END};
+  TEST_ASSERT_EQUAL_HEX32(0x20ff0000U, trace_word(INPUT_S, period_end));
+  char buffer[MAX_TRACE_SIZE];
+  print_trace(buffer, 0x20ff0a5fU);
+  TEST_ASSERT_EQUAL_STRING("#R 20FF0A5F\r\n", buffer);
+}
+
+void test_config(void) {
+  struct config stored = {0xffffU, 0xffU, 0xffU, 0xffU,
+                          0xffU,   0xffU, 0xffU, 0xffffU};
+  TEST_ASSERT_EQUAL_UINT8(DEFAULT_OUTPUT_FORMAT, config_load(&stored).format);
+
+  stored = (struct config){CONFIG_MAGIC, FORMAT_SCPI, 0U, 0U, 0U, 1U, 0U, 0U};
+  stored.check = config_check(&stored);
+  TEST_ASSERT_EQUAL_UINT8(FORMAT_SCPI, config_load(&stored).format);
+
+  stored.format = NUM_FORMATS;
+  stored.check = config_check(&stored);
+  TEST_ASSERT_EQUAL_UINT8(DEFAULT_OUTPUT_FORMAT, config_load(&stored).format);
+
+  stored.format = FORMAT_SCPI;
+  stored.burst_size = 0U;
+  stored.check = config_check(&stored);
+  TEST_ASSERT_EQUAL_UINT8(DEFAULT_OUTPUT_FORMAT, config_load(&stored).format);
+
+  const struct config defaults = config_load(&stored);
+  TEST_ASSERT_EQUAL_HEX16(config_check(&defaults), defaults.check);
+  TEST_ASSERT_EQUAL_UINT32(SERIAL_BAUD_RATE,
+                           serial_baud_rates_[defaults.baud_rate]);
+  TEST_ASSERT_EQUAL_UINT8(BURST_SIZE, defaults.burst_size);
+  TEST_ASSERT_EQUAL_UINT8(0U, defaults.burst_deadline);
+}
+
+void test_execute_command(void) {
+  struct config config = {CONFIG_MAGIC, FORMAT_FIXED, 1U, 0U,
+                          0U,           BURST_SIZE,   0U, 0U};
+  TEST_ASSERT_EQUAL(COMMAND_OK, execute_command(&config, "F2", 2U));
+  TEST_ASSERT_EQUAL_UINT8(FORMAT_SCPI, config.format);
+  TEST_ASSERT_EQUAL(COMMAND_OK, execute_command(&config, "B115200", 7U));
+  TEST_ASSERT_EQUAL_UINT32(115200U, serial_baud_rates_[config.baud_rate]);
+  TEST_ASSERT_EQUAL(COMMAND_OK, execute_command(&config, "A4", 2U));
+  TEST_ASSERT_EQUAL_UINT8(4U, config.averaging);
+  TEST_ASSERT_EQUAL(COMMAND_OK, execute_command(&config, "M1", 2U));
+  TEST_ASSERT_EQUAL_UINT8(1U, config.triggered);
+  TEST_ASSERT_TRUE(config_load(&config).triggered);
+  TEST_ASSERT_EQUAL(COMMAND_OK, execute_command(&config, "N4", 2U));
+  TEST_ASSERT_EQUAL_UINT8(4U, config.burst_size);
+  TEST_ASSERT_EQUAL(COMMAND_OK, execute_command(&config, "D255", 4U));
+  TEST_ASSERT_EQUAL_UINT8(255U, config.burst_deadline);
+  TEST_ASSERT_EQUAL_UINT8(255U, config_load(&config).burst_deadline);
+
+  TEST_ASSERT_EQUAL(COMMAND_TRIGGER, execute_command(&config, "T", 1U));
+  TEST_ASSERT_EQUAL(COMMAND_STATUS, execute_command(&config, "S", 1U));
+  TEST_ASSERT_EQUAL(COMMAND_STORE, execute_command(&config, "W", 1U));
+  TEST_ASSERT_EQUAL(COMMAND_TRACE, execute_command(&config, "R", 1U));
+
+  // nothing changes on errors
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "F4", 2U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "F", 1U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "B1200", 5U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "A5", 2U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "M2", 2U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "T1", 2U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "N0", 2U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "N17", 3U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "D256", 4U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "F1x", 3U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "B99999999", 9U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "f1", 2U));
+  TEST_ASSERT_EQUAL(COMMAND_ERROR, execute_command(&config, "", 0U));
+  TEST_ASSERT_EQUAL_UINT8(FORMAT_SCPI, config.format);
+  TEST_ASSERT_EQUAL_UINT8(4U, config.averaging);
+  TEST_ASSERT_EQUAL_UINT8(4U, config.burst_size);
+}
+
+void test_print_status(void) {
+  char buffer[MAX_STATUS_SIZE];
+  const struct config config = {CONFIG_MAGIC, FORMAT_SCPI, 4U, 4U,
+                                1U,           16U,         255U, 0U};
+  const char *end = print_status_config(buffer, &config);
+  TEST_ASSERT_EQUAL_STRING("#S 2 115200 4 1 16 255", buffer);
+  TEST_ASSERT_EQUAL_size_t(22U, (size_t)(end - buffer));
+  end = print_status_counters(buffer, 65535U, 65535U, 65535U, 65535U);
+  TEST_ASSERT_EQUAL_STRING(" 65535 65535 65535 65535\r\n", buffer);
+  TEST_ASSERT_EQUAL_size_t(MAX_STATUS_SIZE - 1U, (size_t)(end - buffer));
+}
+
+void test_remap_ports(void) {
+  // the pin assignment of the DOU, independent of `enum port1` and `port2`
+  static const unsigned port1_pins[] = {INPUT_Z, INPUT_Y, INPUT_X, INPUT_W,
+                                        INPUT_T, INPUT_S, 0U,      0U};
+  static const unsigned port2_pins[] = {0U, 0U, 0U,       0U,
+                                        0U, 0U, INPUT_S1, INPUT_S4};
+  for (unsigned state = 0U; state <= 0xffffU; ++state) {
+    unsigned expected = 0U;
+    for (unsigned bit = 0U; bit < 8U; ++bit) {
+      expected |= (state >> bit) & 1U ? port1_pins[bit] : 0U;
+      expected |= (state >> (8U + bit)) & 1U ? port2_pins[bit] : 0U;
+    }
+    TEST_ASSERT_EQUAL_HEX16(expected,
+                            remap_ports((u8)state, (u8)(state >> 8U)));
+  }
 }
 
 int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_decode);
+  RUN_TEST(test_decode_in_progress);
+  RUN_TEST(test_decode_overload_flashing);
+  RUN_TEST(test_decode_overload_held);
+  RUN_TEST(test_decode_overload_blank);
+  RUN_TEST(test_capture_without_glitches);
+  RUN_TEST(test_capture_glitches_on_s1_and_s4);
+  RUN_TEST(test_capture_glitches_on_s3);
+  RUN_TEST(test_capture_overload_flashing);
+  RUN_TEST(test_telemetry);
   RUN_TEST(test_print_reading);
+  RUN_TEST(test_remap_ports);
+  RUN_TEST(test_print_output);
+  RUN_TEST(test_reading_to_si);
+  RUN_TEST(test_restart_report);
+  RUN_TEST(test_retained);
+  RUN_TEST(test_trace);
+  RUN_TEST(test_config);
+  RUN_TEST(test_execute_command);
+  RUN_TEST(test_print_status);
   return UNITY_END();
 }
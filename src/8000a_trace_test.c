@@ -0,0 +1,69 @@
+// Runs the 8000A firmware with the decoder trace and the debug probes on the
+// simulated MCU, see `8000a_firmware_test.c`.
+
+#define MSP430_SIM
+#define DECODER_TRACE 8
+#define DEBUG_PROBES  1
+
+#include "8000a_firmware.c"
+#include "8000a_sim.c"
+
+#undef main
+
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const struct mcu_board board_ = {&vt, Tx, SERIAL_BAUD_RATE, Rx, 0U};
+
+static struct sim sim_;
+static struct mcu_edge edges_[SIM_MAX_TICKS + 1U];
+
+// Simulates periods that show 123, followed by the given time of idle bus.
+static size_t simulate(const int periods, const uint64_t idle_us) {
+  static const unsigned digits[] = {0x6U, 0x1U, 0x2U, 0x3U};
+  sim_.length = 0U;
+  for (int i = 0; i < periods; ++i) {
+    sim_period(&sim_, digits);
+  }
+  size_t length = sim_edges(&sim_, edges_);
+  edges_[length] = edges_[length - 1U];
+  edges_[length++].time += idle_us;
+  return length;
+}
+
+void test_probes(void) {
+  const size_t length = simulate(3, 100000U);
+  TEST_ASSERT_EQUAL_INT(MCU_END, mcu_run(&board_, edges_, length));
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n + 123\r\n + 123\r\n", mcu_.output);
+  // one pulse per input of the decoder, i.e. per wakeup but those at the end
+  // of the messages, whereas the pulses of `on_usi()` take no time
+  TEST_ASSERT_EQUAL_UINT32(mcu_.wakeups - 3U, mcu_.probe_pulses);
+  TEST_ASSERT_EQUAL_UINT64(0U, mcu_.probe_ticks);
+  TEST_ASSERT_FALSE(mcu_.probe_level);
+}
+
+void test_trace_after_watchdog_reset(void) {
+  // no readings for a while
+  TEST_ASSERT_EQUAL_INT(MCU_WATCHDOG,
+                        mcu_run(&board_, edges_, simulate(1, 2000000U)));
+  TEST_ASSERT_EQUAL_INT(MCU_END,
+                        mcu_run(&board_, edges_, simulate(1, 100000U)));
+  // the inputs of the period before the reset, from the falling edge of T with
+  // the strobe of the MSD to the strobe of the LSD, which completed the reading
+  TEST_ASSERT_EQUAL_STRING_LEN("#R 66010000\r\n"
+                               "#R 66020006\r\n"
+                               "#R 22030062\r\n"
+                               "#R 21040621\r\n"
+                               "#R A3056213\r\n"
+                               " + 123\r\n#WDT 1 ",
+                               mcu_.output, 5U * 13U + 15U);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_probes);
+  RUN_TEST(test_trace_after_watchdog_reset);
+  return UNITY_END();
+}
@@ -0,0 +1,63 @@
+// Compares the 1900A port remapping tables to the per-bit mapping they
+// replaced, in the order in which the firmware captured the inputs.
+
+#include "1900a_ports.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NUM_CAPTURES (1U << 26U)
+
+// The former `capture_input()`, a branch per bit, with nMUP and DS read from
+// port 2, where they are.
+static unsigned capture_per_bit(const u8 port1, const u8 port2) {
+  return (port2 & OUT_A ? INPUT_A : 0U) | (port1 & OUT_B ? INPUT_B : 0U) |
+         (port2 & OUT_C ? INPUT_C : 0U) | (port2 & OUT_D ? INPUT_D : 0U) |
+         (port2 & AS_6 ? INPUT_AS6 : 0U) | (port2 & AS_5 ? INPUT_AS5 : 0U) |
+         (port2 & AS_4 ? INPUT_AS4 : 0U) | (port1 & AS_3 ? INPUT_AS3 : 0U) |
+         (port1 & AS_2 ? INPUT_AS2 : 0U) | (port1 & AS_1 ? INPUT_AS1 : 0U) |
+         (port1 & RNG_2 ? INPUT_RNG2 : 0U) | (port1 & NML ? INPUT_NML : 0U) |
+         (port1 & OVFL ? INPUT_OVFL : 0U) | (port2 & nMUP ? INPUT_nMUP : 0U) |
+         (port2 & DS ? INPUT_DS : 0U);
+}
+
+static double seconds_since(const struct timespec *start) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  return (double)(now.tv_sec - start->tv_sec) +
+         (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static u16 states_[1U << 16U];
+
+static double bench(unsigned (*capture)(u8, u8), unsigned *checksum) {
+  struct timespec start;
+  timespec_get(&start, TIME_UTC);
+  unsigned sum = 0U;
+  for (size_t i = 0U; i < NUM_CAPTURES; ++i) {
+    const u16 state = states_[i & 0xffffU];
+    sum += capture((u8)state, (u8)(state >> 8U));
+  }
+  *checksum = sum;
+  return seconds_since(&start) / NUM_CAPTURES * 1e9;
+}
+
+int main(void) {
+  // random states, so that the branches are not predictable, as on the bus
+  srand(1900);
+  for (size_t i = 0U; i < sizeof states_ / sizeof states_[0]; ++i) {
+    states_[i] = (u16)rand();
+  }
+
+  unsigned checksums[2];
+  const double per_bit = bench(capture_per_bit, &checksums[0]);
+  const double table = bench(remap_ports, &checksums[1]);
+  printf("per bit: %.2f ns/capture\n", per_bit);
+  printf("table:   %.2f ns/capture\n", table);
+  if (checksums[0] != checksums[1]) {
+    printf("results differ\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
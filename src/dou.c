@@ -4,10 +4,72 @@
 
 // The baud rate must be sufficient to transmit the whole measurement within
 // the nMUP/nT period of approximately 100 ms.
-#define SERIAL_BAUD_RATE    19200 // bps
+#ifndef SERIAL_BAUD_RATE
+#define SERIAL_BAUD_RATE 19200 // bps
+#endif
 #define SERIAL_DATA_BITS    7
 #define STOP_BIT            (1U << ((SERIAL_DATA_BITS) + 1))
 
+// With frame checks enabled, each reading is followed by `*` and the CRC-8 of
+// all characters before it as two hex digits, right before the line ending,
+// e.g. ` +1234*22\r\n`. This lets the host reject readings that were
+// corrupted on the line, which matters more at higher baud rates.
+#ifndef SERIAL_FRAME_CHECK
+#define SERIAL_FRAME_CHECK 0
+#endif
+#define FRAME_CHECK_MARKER  '*'
+#define FRAME_CHECK_SIZE    3 // marker + 2 hex digits
+
+// The baud rates that can be configured, as `f(rate)` for each. The index of
+// the rate is stored in the configuration.
+#define SERIAL_BAUD_RATES(f) f(9600) f(19200) f(38400) f(57600) f(115200)
+#define NUM_BAUD_RATES       5
+#define IS_SERIAL_BAUD_RATE(rate) || SERIAL_BAUD_RATE == (rate)
+_Static_assert(0 SERIAL_BAUD_RATES(IS_SERIAL_BAUD_RATE),
+               "SERIAL_BAUD_RATE is not one of SERIAL_BAUD_RATES");
+
+// Time to send a character at the given rate in ticks of a clock with the
+// given frequency, rounded to the nearest tick.
+#define SERIAL_CHAR_TICKS(frequency, rate)                                     \
+  (((SERIAL_DATA_BITS + 2) * (frequency) + (rate) / 2) / (rate))
+
+// Sends the restart report after a power-on reset as well, which allows to
+// measure the cold start time.
+#ifndef STARTUP_REPORT
+#define STARTUP_REPORT 0
+#endif
+
+// The format of the readings, which is selected by the configuration.
+enum output_format {
+  FORMAT_FIXED, // as shown on the display, see `print_reading()`
+  FORMAT_CSV,   // sequence, timestamp, value and unit, see `print_csv()`
+  FORMAT_SCPI,  // value and unit, see `print_scpi()`
+  FORMAT_BURST, // packed readings, several per line, see `burst_add()`
+  NUM_FORMATS
+};
+#ifndef DEFAULT_OUTPUT_FORMAT
+#define DEFAULT_OUTPUT_FORMAT FORMAT_FIXED
+#endif
+// The burst format can be left out, where it does not fit, as on the G2231.
+#ifndef BURST_FORMAT
+#define BURST_FORMAT 1
+#endif
+_Static_assert(BURST_FORMAT || DEFAULT_OUTPUT_FORMAT != FORMAT_BURST,
+               "default format left out");
+// So can the formats of SI values, CSV and SCPI, with the averaging.
+#ifndef SI_FORMATS
+#define SI_FORMATS 1
+#endif
+_Static_assert(SI_FORMATS || (DEFAULT_OUTPUT_FORMAT != FORMAT_CSV &&
+                              DEFAULT_OUTPUT_FORMAT != FORMAT_SCPI),
+               "default format left out");
+
+// Returns true, if the firmware was built with the given format.
+static bool format_available(const u32 format) {
+  return format < NUM_FORMATS && (BURST_FORMAT || format != FORMAT_BURST) &&
+         (SI_FORMATS || (format != FORMAT_CSV && format != FORMAT_SCPI));
+}
+
 // Extracts the digit with the given index from a BCD sequence.
 // Digits are indexed MSD = N, 2SD = N-1, 3SD = N-2, ..., LSD = 0.
 #define DIGIT(reading, idx) (((reading) >> ((unsigned)(idx) * 4U)) & 0xfU)
@@ -15,6 +77,26 @@
 // The BCD value that is interpreted as a decimal point by `bcd2digit()`.
 #define DECIMAL_POINT_BCD   (0xbU)
 
+// Moves the `pin` bit of a port state to the position of the `input` bit.
+// Both are single-bit constants, so this boils down to a mask and a constant
+// shift, and the compiler combines pins that are shifted by the same distance.
+#define REMAP_PIN(port, pin, input)                                            \
+  ((pin) >= (input) ? ((unsigned)(port) & (pin)) / ((pin) / (input))           \
+                    : ((unsigned)(port) & (pin)) * ((input) / (pin)))
+
+// Expands to `f(0), f(1), ..., f(255)` to initialize a table that is indexed
+// by the state of a port.
+#define PORT_TABLE_4(f, n)  f((n)), f((n) + 1U), f((n) + 2U), f((n) + 3U)
+#define PORT_TABLE_16(f, n)                                                    \
+  PORT_TABLE_4(f, (n)), PORT_TABLE_4(f, (n) + 4U),                             \
+      PORT_TABLE_4(f, (n) + 8U), PORT_TABLE_4(f, (n) + 12U)
+#define PORT_TABLE_64(f, n)                                                    \
+  PORT_TABLE_16(f, (n)), PORT_TABLE_16(f, (n) + 16U),                          \
+      PORT_TABLE_16(f, (n) + 32U), PORT_TABLE_16(f, (n) + 48U)
+#define PORT_TABLE(f)                                                          \
+  PORT_TABLE_64(f, 0U), PORT_TABLE_64(f, 64U), PORT_TABLE_64(f, 128U),         \
+      PORT_TABLE_64(f, 192U)
+
 // Converts the given BCD value to its character representation.
 // Works not only for digits, but also for some useful special characters.
 static char bcd2digit(const unsigned bcd) {
@@ -29,3 +111,447 @@ static char *print_str(char *const begin, const char *end, const char *str) {
   }
   return dst;
 }
+
+// Prints the value in decimal. The digits are found by subtracting powers of
+// ten, because the MSP430 has no divider and a 32-bit division would pull in
+// a sizeable library routine.
+static char *print_uint(char *const begin, const char *end, const u32 value) {
+  static const u32 powers[] = {1000000000U, 100000000U, 10000000U, 1000000U,
+                               100000U,     10000U,     1000U,     100U,
+                               10U,         1U};
+  char *dst = begin;
+  u32 rest = value;
+  for (int i = 0; i < 10 && dst != end; ++i) {
+    unsigned digit = 0U;
+    for (; rest >= powers[i]; rest -= powers[i]) {
+      ++digit;
+    }
+    if (digit != 0U || dst != begin || i == 9) {
+      *dst++ = bcd2digit(digit);
+    }
+  }
+  return dst;
+}
+
+// `#WDT <resets> <ticks>\r\n` is sent after the first reading following a
+// watchdog reset, `#POR ...` after a power-on reset. It gives the number of
+// watchdog resets so far and the time from the reset to the first complete
+// reading in ACLK ticks.
+#define MAX_REPORT_SIZE 24
+
+static char *print_restart_report(char buf[static MAX_REPORT_SIZE],
+                                  const bool watchdog, const unsigned resets,
+                                  const u32 ticks) {
+  const char *end = &buf[MAX_REPORT_SIZE - 1];
+  char *dst = print_str(buf, end, watchdog ? "#WDT " : "#POR ");
+  dst = print_uint(dst, end, resets);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, ticks);
+  dst = print_str(dst, end, "\r\n");
+  *dst = '\0';
+  return dst;
+}
+
+// State that survives a watchdog reset, but not a power cycle. The firmware
+// keeps it in the `.noinit` section, which the start-up code leaves alone, and
+// trusts it only if the check word matches, i.e. after a warm restart.
+struct retained {
+  u16 sequence; // number of readings
+  u16 resets;   // number of watchdog resets
+  u16 check;
+};
+
+static u16 retained_check(const struct retained *r) {
+  return (u16)(0xa5a5U ^ r->sequence ^ (unsigned)(r->resets << 1U));
+}
+
+static bool retained_valid(const struct retained *r) {
+  return r->check == retained_check(r);
+}
+
+// Must be called after each modification of the retained state.
+static void retained_commit(struct retained *r) { r->check = retained_check(r); }
+
+static const u32 serial_baud_rates_[NUM_BAUD_RATES] = {
+#define SERIAL_BAUD_RATE_ENTRY(rate) (rate),
+    SERIAL_BAUD_RATES(SERIAL_BAUD_RATE_ENTRY)};
+
+// Returns the index of the rate in `SERIAL_BAUD_RATES` or `NUM_BAUD_RATES`, if
+// it is not one of them.
+static u8 serial_baud_rate_index(const u32 rate) {
+  u8 i = 0U;
+  for (; i < NUM_BAUD_RATES && serial_baud_rates_[i] != rate; ++i) {
+  }
+  return i;
+}
+
+// Settings that persist in the information memory, which is left alone when
+// the firmware is programmed. Erased or otherwise invalid settings are
+// replaced by the defaults.
+struct config {
+  u16 magic;
+  u8 format;    // `enum output_format`
+  u8 baud_rate; // index into `SERIAL_BAUD_RATES`
+  u8 averaging; // log2 of the number of readings per value, see `si_average`
+  u8 triggered; // readings are only sent on request
+  u8 burst_size; // readings per burst frame at most, 1 to `BURST_SIZE`
+  u8 burst_deadline; // of a burst frame in tenths of a second, 0 = none
+  u16 check;
+};
+#define CONFIG_MAGIC  (0xc0f3U)
+#define MAX_AVERAGING 4 // 16 readings, so that 8 digits cannot overflow
+#define MAX_DEADLINE  255
+
+static u16 config_check(const struct config *c) {
+  return (u16)(0xa5a5U ^ c->magic ^ (unsigned)(c->format << 8U) ^
+               c->baud_rate ^ (unsigned)(c->averaging << 12U) ^
+               (unsigned)(c->triggered << 4U) ^
+               (unsigned)(c->burst_size << 5U) ^
+               (unsigned)(c->burst_deadline << 8U));
+}
+
+// Must be called after each modification of the configuration.
+static void config_commit(struct config *c) { c->check = config_check(c); }
+
+static bool config_valid(const struct config *c) {
+  return c->magic == CONFIG_MAGIC && c->check == config_check(c) &&
+         format_available(c->format) && c->baud_rate < NUM_BAUD_RATES &&
+         c->averaging <= MAX_AVERAGING && c->triggered <= 1U &&
+         c->burst_size >= 1U && c->burst_size <= BURST_SIZE;
+}
+
+static struct config config_load(const volatile struct config *stored) {
+  const struct config c = *stored;
+  if (config_valid(&c)) {
+    return c;
+  }
+  struct config defaults = {CONFIG_MAGIC, DEFAULT_OUTPUT_FORMAT,
+                            serial_baud_rate_index(SERIAL_BAUD_RATE),
+                            0U,
+                            0U,
+                            BURST_SIZE,
+                            0U,
+                            0U};
+  config_commit(&defaults);
+  return defaults;
+}
+
+// The decoder trace keeps the latest inputs of the decoder in a ring, each
+// packed into one word together with the state that it led to, see
+// `trace_word()` of the meter. Like `struct retained`, the firmware keeps it in
+// the `.noinit` section, so that it tells what the decoder saw before a
+// watchdog reset. Built with e.g. `DECODER_TRACE=8`, the number of words, which
+// must be a power of two. With 0, there is no trace.
+#ifndef DECODER_TRACE
+#define DECODER_TRACE 0
+#endif
+_Static_assert((DECODER_TRACE & (DECODER_TRACE - 1)) == 0,
+               "DECODER_TRACE is not a power of two");
+
+#if DECODER_TRACE > 0
+struct trace {
+  u32 words[DECODER_TRACE];
+  u16 next;  // index of the word to be added next
+  u16 count; // of the words in the ring
+  u16 check;
+};
+
+static u16 trace_check(const struct trace *t) {
+  return (u16)(0x5a5aU ^ t->next ^ (unsigned)(t->count << 8U));
+}
+
+static bool trace_valid(const struct trace *t) {
+  return t->check == trace_check(t) && t->next < DECODER_TRACE &&
+         t->count <= DECODER_TRACE;
+}
+
+static void trace_clear(struct trace *t) {
+  t->next = 0U;
+  t->count = 0U;
+  t->check = trace_check(t);
+}
+
+static void trace_add(struct trace *t, const u32 word) {
+  t->words[t->next] = word;
+  t->next = (u16)((t->next + 1U) & (DECODER_TRACE - 1U));
+  t->count = t->count < DECODER_TRACE ? (u16)(t->count + 1U) : t->count;
+  t->check = trace_check(t);
+}
+
+// Returns the word with the given index, 0 being the oldest.
+static u32 trace_at(const struct trace *t, const unsigned index) {
+  const unsigned oldest = (unsigned)t->next - t->count;
+  return t->words[(oldest + index) & (DECODER_TRACE - 1U)];
+}
+#endif
+
+// Commands are received as lines of up to `MAX_COMMAND_SIZE` characters, e.g.
+// `F1\r`. Each is answered with `#OK\r\n` or `#ERR\r\n`, unless noted
+// otherwise.
+//
+//   F<n>    selects the output format `enum output_format` n
+//   B<rate> sets the baud rate, which takes effect after the answer
+//   A<n>    averages 2^n readings per value of the CSV and SCPI formats
+//   M<n>    sends readings continuously (0) or only on request (1)
+//   N<n>    sends a burst frame after at most n readings
+//   D<n>    sends a burst frame before it is older than n tenths of a second
+//   T       requests a reading, which is the answer
+//   S       queries the status, see `print_status()`
+//   W       stores the configuration in the information memory
+//   R       dumps the decoder trace, if built with one, see `struct trace`
+//
+// `TRIGGER_CHAR` on its own, i.e. without line ending, is answered with the
+// latest complete reading right away, or with the next one, if there is none
+// yet. It is the trigger with the least latency.
+#define MAX_COMMAND_SIZE 8
+#define TRIGGER_CHAR     '?'
+
+enum command_action {
+  COMMAND_ERROR,
+  COMMAND_OK,
+  COMMAND_TRIGGER,
+  COMMAND_STATUS,
+  COMMAND_STORE,
+  COMMAND_TRACE
+};
+
+// Applies a command to the configuration and returns what is left to do.
+static enum command_action execute_command(struct config *c,
+                                           const volatile char *line,
+                                           const unsigned length) {
+  u32 argument = 0U;
+  for (unsigned i = 1U; i < length; ++i) {
+    const char digit = line[i];
+    if (digit < '0' || digit > '9' || argument > 999999U) {
+      return COMMAND_ERROR;
+    }
+    argument = argument * 10U + (u32)(digit - '0');
+  }
+  const bool has_argument = length > 1U;
+  switch (length > 0U ? line[0] : '\0') {
+  case 'F':
+    if (!has_argument || !format_available(argument)) {
+      return COMMAND_ERROR;
+    }
+    c->format = (u8)argument;
+    break;
+  case 'B': {
+    const u8 index = serial_baud_rate_index(argument);
+    if (index == NUM_BAUD_RATES) {
+      return COMMAND_ERROR;
+    }
+    c->baud_rate = index;
+    break;
+  }
+  case 'A':
+    if (!has_argument || argument > MAX_AVERAGING) {
+      return COMMAND_ERROR;
+    }
+    c->averaging = (u8)argument;
+    break;
+  case 'M':
+    if (!has_argument || argument > 1U) {
+      return COMMAND_ERROR;
+    }
+    c->triggered = (u8)argument;
+    break;
+  case 'N':
+    if (!has_argument || argument < 1U || argument > BURST_SIZE) {
+      return COMMAND_ERROR;
+    }
+    c->burst_size = (u8)argument;
+    break;
+  case 'D':
+    if (!has_argument || argument > MAX_DEADLINE) {
+      return COMMAND_ERROR;
+    }
+    c->burst_deadline = (u8)argument;
+    break;
+  case 'T':
+    return has_argument ? COMMAND_ERROR : COMMAND_TRIGGER;
+  case 'S':
+    return has_argument ? COMMAND_ERROR : COMMAND_STATUS;
+  case 'W':
+    return has_argument ? COMMAND_ERROR : COMMAND_STORE;
+#if DECODER_TRACE > 0
+  case 'R':
+    return has_argument ? COMMAND_ERROR : COMMAND_TRACE;
+#endif
+  default:
+    return COMMAND_ERROR;
+  }
+  config_commit(c);
+  return COMMAND_OK;
+}
+
+// `#S <format> <baud rate> <averaging> <mode> <burst size> <deadline>
+// <sequence> <resets> <errors> <latency>\r\n` gives the configuration and the
+// counters, where `<errors>` counts the commands that were received corrupted
+// or too long, and `<latency>` is the time in ACLK ticks from the end of the
+// latest trigger to the start of its answer. The line is printed in two parts,
+// the configuration and the counters, so that the buffer need not hold all of
+// it.
+#define MAX_STATUS_SIZE 27 // the counters, the larger part
+
+static char *print_status_config(char buf[static MAX_STATUS_SIZE],
+                                 const struct config *c) {
+  const char *end = &buf[MAX_STATUS_SIZE - 1];
+  char *dst = print_str(buf, end, "#S ");
+  dst = print_uint(dst, end, c->format);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, serial_baud_rates_[c->baud_rate]);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, c->averaging);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, c->triggered);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, c->burst_size);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, c->burst_deadline);
+  *dst = '\0';
+  return dst;
+}
+
+static char *print_status_counters(char buf[static MAX_STATUS_SIZE],
+                                   const unsigned sequence,
+                                   const unsigned resets, const unsigned errors,
+                                   const unsigned latency) {
+  const char *end = &buf[MAX_STATUS_SIZE - 1];
+  char *dst = print_str(buf, end, " ");
+  dst = print_uint(dst, end, sequence);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, resets);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, errors);
+  dst = print_str(dst, end, " ");
+  dst = print_uint(dst, end, latency);
+  dst = print_str(dst, end, "\r\n");
+  *dst = '\0';
+  return dst;
+}
+
+// A burst frame packs up to `config.burst_size` consecutive readings into one
+// line:
+//
+//   #D<sequence> <timestamp> <reading><delta>... <span>\r\n
+//
+// The first reading is given as the packed word of the decoder, the others as
+// the difference to their predecessor, zig-zag encoded, so that a change by a
+// few counts takes one character. <timestamp> is that of the first reading and
+// <span> the ACLK ticks from there to the last one; the readings are evenly
+// spaced by the measurement period. All numbers are varints of five bits per
+// character, least significant first: '0' plus the bits, plus 32, if more
+// characters follow.
+//
+// The frame is sent, when it holds `config.burst_size` readings, or when the
+// next reading would be due after the deadline, judged by the interval of the
+// latest two. The host gets fewer, longer lines then, at the cost of latency.
+#define MAX_BURST_SIZE 50
+// space, span and line ending, which are reserved until the frame is finished
+#define BURST_TRAILER_SIZE (1 + MAX_VARINT_SIZE + 2)
+
+struct burst {
+  u32 previous;  // reading
+  u32 timestamp; // of the first reading
+  u32 span;      // from the first to the latest reading
+  u8 count;      // of the readings in the frame so far
+  u8 length;     // of the frame so far
+};
+
+static char *print_varint(char *const begin, const char *end, u32 value) {
+  char *dst = begin;
+  for (; dst != end; ++dst) {
+    const unsigned bits = value & (VARINT_MORE - 1U);
+    value >>= VARINT_BITS;
+    *dst = (char)('0' + bits + (value != 0U ? VARINT_MORE : 0U));
+    if (value == 0U) {
+      return dst + 1;
+    }
+  }
+  return dst;
+}
+
+// Terminates the burst frame in `buf` and starts the next one.
+static char *burst_finish(char buf[static MAX_BURST_SIZE], struct burst *b) {
+  const char *end = &buf[MAX_BURST_SIZE - 1];
+  char *dst = print_str(&buf[b->length], end, " ");
+  dst = print_varint(dst, end, b->span);
+  dst = print_str(dst, end, "\r\n");
+  *dst = '\0';
+  b->count = 0U;
+  return dst;
+}
+
+// Adds a reading to the burst frame in `buf`. The frame is encoded on the fly,
+// so the buffer must be left alone until it is finished. Returns true, if it is
+// finished, i.e. full or due, and terminated. The `deadline` is given in ACLK
+// ticks, 0 for none.
+static bool burst_add(char buf[static MAX_BURST_SIZE], struct burst *b,
+                      const u32 reading, const u16 sequence,
+                      const u32 timestamp, const u8 size,
+                      const u32 deadline) {
+  const char *end = &buf[MAX_BURST_SIZE - 1];
+  char *dst = &buf[b->length];
+  if (b->count == 0U) {
+    dst = print_str(buf, end, "#D");
+    dst = print_varint(dst, end, sequence);
+    dst = print_str(dst, end, " ");
+    dst = print_varint(dst, end, timestamp);
+    dst = print_str(dst, end, " ");
+    dst = print_varint(dst, end, reading);
+    b->timestamp = timestamp;
+    b->span = 0U;
+  } else {
+    const u32 delta = reading - b->previous;
+    dst = print_varint(dst, end,
+                       (delta >> 31U) != 0U ? ~(delta << 1U) : delta << 1U);
+  }
+  const u32 span = timestamp - b->timestamp;
+  const u32 interval = span - b->span;
+  b->previous = reading;
+  b->span = span;
+  b->count += 1U;
+  b->length = (u8)(dst - buf);
+  // finished early, if the next delta might not fit
+  if (b->count < size &&
+      b->length + MAX_VARINT_SIZE + BURST_TRAILER_SIZE < MAX_BURST_SIZE &&
+      (deadline == 0U || span + interval <= deadline)) {
+    return false;
+  }
+  burst_finish(buf, b);
+  return true;
+}
+
+// Updates the CRC-8 (polynomial 0x07, initial value 0) with one character.
+// It is computed bitwise, as a table would not fit the G2231's flash, and only
+// takes a fraction of a character time, so it is done while the character is
+// being shifted out.
+static u8 frame_check_update(u8 crc, const char c) {
+  crc ^= (u8)c;
+  for (int i = 0; i < 8; ++i) {
+    const unsigned shifted = (unsigned)crc << 1U;
+    crc = (u8)((crc & 0x80U) ? shifted ^ 0x07U : shifted);
+  }
+  return crc;
+}
+
+static char hex_digit(const unsigned value) {
+  static const char digits[] = "0123456789ABCDEF";
+  return digits[value & 0xfU];
+}
+
+#if DECODER_TRACE > 0
+// `#R <word>\r\n` gives one word of the decoder trace in hex.
+#define MAX_TRACE_SIZE 14
+
+static char *print_trace(char buf[static MAX_TRACE_SIZE], const u32 word) {
+  const char *end = &buf[MAX_TRACE_SIZE - 1];
+  char *dst = print_str(buf, end, "#R ");
+  for (unsigned shift = 32U; shift > 0U && dst != end; shift -= 4U) {
+    *dst++ = hex_digit((unsigned)(word >> (shift - 4U)));
+  }
+  dst = print_str(dst, end, "\r\n");
+  *dst = '\0';
+  return dst;
+}
+#endif
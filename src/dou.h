@@ -6,9 +6,23 @@
 
 #define nullptr ((void *)0)
 #define bool _Bool
+#define true ((bool)1)
+#define false ((bool)0)
 
 typedef unsigned char u8;
 typedef __UINT16_TYPE__ u16;
 typedef __UINT32_TYPE__ u32;
+typedef signed char i8;
+typedef __INT16_TYPE__ i16;
+typedef __INT32_TYPE__ i32;
+
+// The burst frames are encoded by `burst_add()` and decoded on the host by
+// `parse_burst()`.
+#ifndef BURST_SIZE
+#define BURST_SIZE 16 // readings per frame at most
+#endif
+#define MAX_VARINT_SIZE 7 // of 32 bits
+#define VARINT_BITS     5
+#define VARINT_MORE     (1U << VARINT_BITS)
 
 #endif // DOU_H_INCLUDED
@@ -0,0 +1,100 @@
+// Differential testing of an optimized decoder against a reference model.
+//
+// A meter wraps both decoders into a `struct equivalence`, which feeds one
+// input to both and tells whether they still agree. The checks run them side
+// by side on all short input sequences and on long streams, stop at the first
+// divergence and describe it in `equivalence_failure_`.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct equivalence {
+  void (*reset)(void);
+  bool (*step)(unsigned input); // false, if the decoders diverge
+};
+
+// inputs shown before a divergence
+#define EQUIVALENCE_HISTORY 12
+
+static char equivalence_failure_[256];
+
+static void report_divergence(const unsigned *inputs, const size_t count,
+                              const size_t position) {
+  const size_t first =
+      count > EQUIVALENCE_HISTORY ? count - EQUIVALENCE_HISTORY : 0U;
+  int length = snprintf(equivalence_failure_, sizeof equivalence_failure_,
+                        "input %zu diverged, inputs until then:", position);
+  for (size_t i = first; i < count; ++i) {
+    length += snprintf(&equivalence_failure_[length],
+                       sizeof equivalence_failure_ - (size_t)length, " %04x",
+                       inputs[i]);
+  }
+}
+
+// Runs all sequences of `length` inputs out of the `alphabet`, each from the
+// reset. Returns false at the first divergence.
+static bool check_exhaustive(const struct equivalence *eq,
+                             const unsigned *alphabet, const size_t size,
+                             const size_t length) {
+  unsigned inputs[16];
+  size_t digits[16] = {0U};
+  if (length > 16U) {
+    return false;
+  }
+  for (;;) {
+    eq->reset();
+    for (size_t i = 0U; i < length; ++i) {
+      inputs[i] = alphabet[digits[i]];
+      if (!eq->step(inputs[i])) {
+        report_divergence(inputs, i + 1U, i);
+        return false;
+      }
+    }
+    // the next sequence, counting in base `size`
+    size_t i = 0U;
+    for (; i < length && ++digits[i] == size; ++i) {
+      digits[i] = 0U;
+    }
+    if (i == length) {
+      return true;
+    }
+  }
+}
+
+// Runs the stream from the reset. Returns false at the first divergence.
+static bool check_stream(const struct equivalence *eq, const unsigned *inputs,
+                         const size_t length) {
+  eq->reset();
+  for (size_t i = 0U; i < length; ++i) {
+    if (!eq->step(inputs[i])) {
+      report_divergence(inputs, i + 1U, i);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Fills the stream with random inputs, which have only the bits of the `mask`.
+static void random_stream(unsigned *inputs, const size_t length,
+                          const unsigned mask) {
+  for (size_t i = 0U; i < length; ++i) {
+    inputs[i] = ((unsigned)rand() << 8U ^ (unsigned)rand()) & mask;
+  }
+}
+
+// Flips one random bit of the `mask` in about one of `rate` inputs.
+static void fuzz_stream(unsigned *inputs, const size_t length,
+                        const unsigned mask, const int rate) {
+  unsigned bits[16];
+  size_t num_bits = 0U;
+  for (unsigned bit = 1U; bit != 0U && bit <= mask; bit <<= 1U) {
+    if ((mask & bit) != 0U && num_bits < 16U) {
+      bits[num_bits++] = bit;
+    }
+  }
+  for (size_t i = 0U; i < length; ++i) {
+    if (rand() % rate == 0) {
+      inputs[i] ^= bits[(size_t)rand() % num_bits];
+    }
+  }
+}
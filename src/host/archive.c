@@ -0,0 +1,396 @@
+// Append-only columnar archive for decoded DOU readings.
+//
+// The file is a header followed by blocks of up to `ARCHIVE_BLOCK_ROWS` rows.
+// Within a block, every column is stored as runs of equal values, because a
+// meter tends to show the same reading, range and unit for a long time. The
+// timestamps are delta encoded before, so that a steady update rate collapses
+// into a single run as well.
+// All structures are naturally aligned and stored in host byte order, so that
+// a reader can use them in place from a read-only memory mapping.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "../dou.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ARCHIVE_MAGIC       (0x31524144U) // "DAR1"
+#define ARCHIVE_BLOCK_MAGIC (0x4b4c4244U) // "DBLK"
+#define ARCHIVE_BLOCK_ROWS  (4096U)
+
+enum archive_column {
+  COLUMN_TIMESTAMP,
+  COLUMN_METER,
+  COLUMN_READING,
+  COLUMN_DECIMAL_POINT,
+  COLUMN_UNIT,
+  COLUMN_FLAGS,
+  ARCHIVE_COLUMNS
+};
+
+// A decoded reading, as produced by the decoders of the DOUs.
+struct archive_row {
+  uint64_t timestamp; // µs
+  u16 meter;
+  u8 decimal_point; // `decimal_point_digit` of the decoder, 0 for none
+  u8 unit;          // `enum unit` of the 1900A
+  u32 reading;      // packed BCD
+  u8 flags;         // e.g. overload
+};
+
+struct archive_header {
+  u32 magic;
+  u32 block_rows;
+};
+
+struct archive_block {
+  u32 magic;
+  u32 rows;
+  uint64_t first_timestamp;
+  uint64_t last_timestamp;
+  u32 runs[ARCHIVE_COLUMNS]; // number of runs per column
+  u32 size;                  // of the block including this header
+  u32 reserved_;
+};
+_Static_assert(sizeof(struct archive_block) % 8U == 0U,
+               "runs must stay aligned");
+
+// Runs of the timestamp column, which describe the rows after the first one.
+struct archive_delta_run {
+  int64_t delta;
+  uint64_t count;
+};
+
+// Runs of all other columns.
+struct archive_run {
+  u32 value;
+  u32 count;
+};
+
+struct archive_writer {
+  FILE *file;
+  size_t count;
+  struct archive_row rows[ARCHIVE_BLOCK_ROWS];
+  struct archive_delta_run deltas[ARCHIVE_BLOCK_ROWS];
+  struct archive_run runs[ARCHIVE_COLUMNS - 1][ARCHIVE_BLOCK_ROWS];
+};
+
+struct archive_reader {
+  const u8 *map;
+  size_t size;
+  size_t offset; // of the next block
+};
+
+static u32 column_value(const struct archive_row *row,
+                        const enum archive_column column) {
+  switch (column) {
+  case COLUMN_METER:
+    return row->meter;
+  case COLUMN_READING:
+    return row->reading;
+  case COLUMN_DECIMAL_POINT:
+    return row->decimal_point;
+  case COLUMN_UNIT:
+    return row->unit;
+  case COLUMN_FLAGS:
+    return row->flags;
+  default:
+    return 0U;
+  }
+}
+
+static u32 encode_runs(const struct archive_row *rows, const size_t count,
+                       const enum archive_column column,
+                       struct archive_run *runs) {
+  u32 num_runs = 0U;
+  for (size_t i = 0U; i < count; ++i) {
+    const u32 value = column_value(&rows[i], column);
+    if (num_runs == 0U || runs[num_runs - 1U].value != value) {
+      runs[num_runs++] = (struct archive_run){value, 0U};
+    }
+    runs[num_runs - 1U].count += 1U;
+  }
+  return num_runs;
+}
+
+static u32 encode_deltas(const struct archive_row *rows, const size_t count,
+                         struct archive_delta_run *runs) {
+  u32 num_runs = 0U;
+  for (size_t i = 1U; i < count; ++i) {
+    const int64_t delta =
+        (int64_t)(rows[i].timestamp - rows[i - 1U].timestamp);
+    if (num_runs == 0U || runs[num_runs - 1U].delta != delta) {
+      runs[num_runs++] = (struct archive_delta_run){delta, 0U};
+    }
+    runs[num_runs - 1U].count += 1U;
+  }
+  return num_runs;
+}
+
+// Encodes the pending rows into a block and appends it to the file.
+static bool archive_flush(struct archive_writer *writer) {
+  if (writer->count == 0U) {
+    return true;
+  }
+  struct archive_block block = {
+      ARCHIVE_BLOCK_MAGIC,
+      (u32)writer->count,
+      writer->rows[0].timestamp,
+      writer->rows[writer->count - 1U].timestamp,
+      {0U},
+      sizeof block,
+      0U};
+  block.runs[COLUMN_TIMESTAMP] =
+      encode_deltas(writer->rows, writer->count, writer->deltas);
+  block.size +=
+      (u32)(block.runs[COLUMN_TIMESTAMP] * sizeof writer->deltas[0]);
+  for (int c = COLUMN_METER; c < ARCHIVE_COLUMNS; ++c) {
+    block.runs[c] = encode_runs(writer->rows, writer->count, c,
+                                writer->runs[c - COLUMN_METER]);
+    block.size += (u32)(block.runs[c] * sizeof writer->runs[0][0]);
+  }
+  // pad to keep the next block aligned
+  static const u8 padding[8] = {0U};
+  const u32 padding_size = (8U - block.size % 8U) % 8U;
+  block.size += padding_size;
+
+  bool ok = fwrite(&block, sizeof block, 1U, writer->file) == 1U;
+  ok = ok && fwrite(writer->deltas, sizeof writer->deltas[0],
+                    block.runs[COLUMN_TIMESTAMP],
+                    writer->file) == block.runs[COLUMN_TIMESTAMP];
+  for (int c = COLUMN_METER; ok && c < ARCHIVE_COLUMNS; ++c) {
+    ok = fwrite(writer->runs[c - COLUMN_METER], sizeof writer->runs[0][0],
+                block.runs[c], writer->file) == block.runs[c];
+  }
+  ok = ok && fwrite(padding, 1U, padding_size, writer->file) == padding_size;
+  ok = ok && fflush(writer->file) == 0;
+  writer->count = 0U;
+  return ok;
+}
+
+static bool archive_append(struct archive_writer *writer,
+                           const struct archive_row *row) {
+  writer->rows[writer->count++] = *row;
+  if (writer->count == ARCHIVE_BLOCK_ROWS) {
+    return archive_flush(writer);
+  }
+  return true;
+}
+
+static bool archive_open_reader(struct archive_reader *reader,
+                                const char *path);
+static const struct archive_block *
+archive_next_block(struct archive_reader *reader);
+static void archive_close_reader(struct archive_reader *reader);
+
+// Opens an archive for appending, creating it if necessary. What follows the
+// last complete block, e.g. a block that was cut short by a crash, is cut off,
+// so that the new blocks can be read.
+static bool archive_open_writer(struct archive_writer *writer,
+                                const char *path) {
+  writer->count = 0U;
+  writer->file = fopen(path, "ab");
+  if (writer->file == nullptr) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fileno(writer->file), &st) != 0) {
+    fclose(writer->file);
+    return false;
+  }
+  // an incomplete header is written again
+  off_t end = 0;
+  if ((size_t)st.st_size >= sizeof(struct archive_header)) {
+    struct archive_reader reader;
+    if (!archive_open_reader(&reader, path)) {
+      fclose(writer->file); // not an archive
+      return false;
+    }
+    while (archive_next_block(&reader) != nullptr) {
+    }
+    end = (off_t)reader.offset;
+    archive_close_reader(&reader);
+  }
+  if (end != st.st_size && ftruncate(fileno(writer->file), end) != 0) {
+    fclose(writer->file);
+    return false;
+  }
+  if (end == 0) {
+    const struct archive_header header = {ARCHIVE_MAGIC, ARCHIVE_BLOCK_ROWS};
+    if (fwrite(&header, sizeof header, 1U, writer->file) != 1U) {
+      fclose(writer->file);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool archive_close_writer(struct archive_writer *writer) {
+  const bool ok = archive_flush(writer);
+  return fclose(writer->file) == 0 && ok;
+}
+
+static bool archive_open_reader(struct archive_reader *reader,
+                                const char *path) {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (size_t)st.st_size < sizeof(struct archive_header)) {
+    close(fd);
+    return false;
+  }
+  void *map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  const struct archive_header *header = map;
+  if (header->magic != ARCHIVE_MAGIC) {
+    munmap(map, (size_t)st.st_size);
+    return false;
+  }
+  *reader = (struct archive_reader){map, (size_t)st.st_size, sizeof *header};
+  return true;
+}
+
+static void archive_close_reader(struct archive_reader *reader) {
+  munmap((void *)reader->map, reader->size);
+}
+
+static const struct archive_delta_run *
+archive_deltas(const struct archive_block *block) {
+  return (const struct archive_delta_run *)&block[1];
+}
+
+// Returns the runs of any column but the timestamps.
+static const struct archive_run *
+archive_runs(const struct archive_block *block,
+             const enum archive_column column) {
+  const struct archive_run *runs = (const struct archive_run *)&archive_deltas(
+      block)[block->runs[COLUMN_TIMESTAMP]];
+  for (int c = COLUMN_METER; c < (int)column; ++c) {
+    runs += block->runs[c];
+  }
+  return runs;
+}
+
+// Checks that the runs of the block fit into its size, which fits into the
+// given space, and that each column has as many rows as the block, so that it
+// can be decoded safely.
+static bool archive_block_valid(const struct archive_block *block,
+                                const size_t available) {
+  if (block->magic != ARCHIVE_BLOCK_MAGIC || block->size < sizeof *block ||
+      block->size > available || block->size % 8U != 0U || block->rows == 0U ||
+      block->rows > ARCHIVE_BLOCK_ROWS ||
+      block->runs[COLUMN_TIMESTAMP] >= block->rows) {
+    return false;
+  }
+  uint64_t size = sizeof *block + (uint64_t)block->runs[COLUMN_TIMESTAMP] *
+                                      sizeof(struct archive_delta_run);
+  for (int c = COLUMN_METER; c < ARCHIVE_COLUMNS; ++c) {
+    if (block->runs[c] > block->rows) {
+      return false;
+    }
+    size += (uint64_t)block->runs[c] * sizeof(struct archive_run);
+  }
+  if (size > block->size) {
+    return false;
+  }
+
+  const struct archive_delta_run *deltas = archive_deltas(block);
+  uint64_t rows = 1U; // the first one is not a delta
+  for (u32 r = 0U; r < block->runs[COLUMN_TIMESTAMP]; ++r) {
+    if (deltas[r].count > block->rows) {
+      return false;
+    }
+    rows += deltas[r].count;
+  }
+  if (rows != block->rows) {
+    return false;
+  }
+  for (int c = COLUMN_METER; c < ARCHIVE_COLUMNS; ++c) {
+    const struct archive_run *runs = archive_runs(block, c);
+    rows = 0U;
+    for (u32 r = 0U; r < block->runs[c]; ++r) {
+      rows += runs[r].count;
+    }
+    if (rows != block->rows) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the next complete block or `nullptr` at the end of the archive.
+// A block that was cut short, e.g. by a crash while writing, or that is
+// corrupt ends the archive.
+static const struct archive_block *
+archive_next_block(struct archive_reader *reader) {
+  if (reader->size - reader->offset < sizeof(struct archive_block)) {
+    return nullptr;
+  }
+  const struct archive_block *block =
+      (const struct archive_block *)&reader->map[reader->offset];
+  if (!archive_block_valid(block, reader->size - reader->offset)) {
+    return nullptr;
+  }
+  reader->offset += block->size;
+  return block;
+}
+
+static void decode_runs(const struct archive_block *block,
+                        const enum archive_column column,
+                        struct archive_row *rows) {
+  const struct archive_run *runs = archive_runs(block, column);
+  size_t row = 0U;
+  for (u32 r = 0U; r < block->runs[column]; ++r) {
+    for (u32 i = 0U; i < runs[r].count; ++i, ++row) {
+      switch (column) {
+      case COLUMN_METER:
+        rows[row].meter = (u16)runs[r].value;
+        break;
+      case COLUMN_READING:
+        rows[row].reading = runs[r].value;
+        break;
+      case COLUMN_DECIMAL_POINT:
+        rows[row].decimal_point = (u8)runs[r].value;
+        break;
+      case COLUMN_UNIT:
+        rows[row].unit = (u8)runs[r].value;
+        break;
+      default:
+        rows[row].flags = (u8)runs[r].value;
+        break;
+      }
+    }
+  }
+}
+
+// Decodes all rows of the block to `rows`, which must hold `block->rows`. The
+// block must have been checked by `archive_next_block()`.
+static void archive_decode_block(const struct archive_block *block,
+                                 struct archive_row rows[static 1]) {
+  const struct archive_delta_run *deltas = archive_deltas(block);
+  uint64_t timestamp = block->first_timestamp;
+  rows[0].timestamp = timestamp;
+  size_t row = 1U;
+  for (u32 r = 0U; r < block->runs[COLUMN_TIMESTAMP]; ++r) {
+    for (uint64_t i = 0U; i < deltas[r].count; ++i, ++row) {
+      timestamp += (uint64_t)deltas[r].delta;
+      rows[row].timestamp = timestamp;
+    }
+  }
+  for (int c = COLUMN_METER; c < ARCHIVE_COLUMNS; ++c) {
+    decode_runs(block, c, rows);
+  }
+}
@@ -0,0 +1,212 @@
+// Tests whether readings survive a round trip through the archive.
+
+#include "archive.c"
+
+#include <unity.h>
+
+#include <stdlib.h>
+
+#define NUM_ROWS (3U * ARCHIVE_BLOCK_ROWS + 100U)
+
+static char path_[32];
+static struct archive_writer writer_;
+static struct archive_row expected_[NUM_ROWS];
+static struct archive_row actual_[ARCHIVE_BLOCK_ROWS];
+
+void setUp(void) {
+  strcpy(path_, "/tmp/archive_test_XXXXXX");
+  const int fd = mkstemp(path_);
+  TEST_ASSERT_TRUE(fd >= 0);
+  close(fd);
+  remove(path_);
+}
+
+void tearDown(void) { remove(path_); }
+
+static struct archive_row make_row(const size_t i) {
+  // a 1900A showing a slowly drifting frequency with an occasional range
+  // change, updating every 100 ms with a little jitter now and then
+  return (struct archive_row){
+      1700000000000000U + i * 100000U + (i % 1000U == 0U ? 3U : 0U),
+      (u16)(i < NUM_ROWS / 2U ? 1U : 2U),
+      (u8)(i % 2000U < 1000U ? 3U : 4U),
+      3U,
+      0x10000000U | (u32)(i / 64U),
+      (u8)(i % 5000U == 0U ? 1U : 0U)};
+}
+
+static void assert_equal_rows(const struct archive_row *expected,
+                              const struct archive_row *actual,
+                              const size_t count) {
+  for (size_t i = 0U; i < count; ++i) {
+    TEST_ASSERT_EQUAL_UINT64(expected[i].timestamp, actual[i].timestamp);
+    TEST_ASSERT_EQUAL_UINT16(expected[i].meter, actual[i].meter);
+    TEST_ASSERT_EQUAL_HEX32(expected[i].reading, actual[i].reading);
+    TEST_ASSERT_EQUAL_UINT8(expected[i].decimal_point,
+                            actual[i].decimal_point);
+    TEST_ASSERT_EQUAL_UINT8(expected[i].unit, actual[i].unit);
+    TEST_ASSERT_EQUAL_UINT8(expected[i].flags, actual[i].flags);
+  }
+}
+
+void test_round_trip(void) {
+  // write in two sessions to check that appending continues the archive
+  TEST_ASSERT_TRUE(archive_open_writer(&writer_, path_));
+  for (size_t i = 0U; i < NUM_ROWS; ++i) {
+    expected_[i] = make_row(i);
+    if (i == NUM_ROWS / 3U) {
+      TEST_ASSERT_TRUE(archive_close_writer(&writer_));
+      TEST_ASSERT_TRUE(archive_open_writer(&writer_, path_));
+    }
+    TEST_ASSERT_TRUE(archive_append(&writer_, &expected_[i]));
+  }
+  TEST_ASSERT_TRUE(archive_close_writer(&writer_));
+
+  struct archive_reader reader;
+  TEST_ASSERT_TRUE(archive_open_reader(&reader, path_));
+  size_t rows = 0U;
+  for (const struct archive_block *block = archive_next_block(&reader);
+       block != nullptr; block = archive_next_block(&reader)) {
+    TEST_ASSERT_TRUE(block->rows <= ARCHIVE_BLOCK_ROWS);
+    archive_decode_block(block, actual_);
+    assert_equal_rows(&expected_[rows], actual_, block->rows);
+    TEST_ASSERT_EQUAL_UINT64(expected_[rows].timestamp,
+                             block->first_timestamp);
+    rows += block->rows;
+    TEST_ASSERT_EQUAL_UINT64(expected_[rows - 1U].timestamp,
+                             block->last_timestamp);
+  }
+  TEST_ASSERT_EQUAL_size_t(NUM_ROWS, rows);
+
+  // mostly constant values must compress well below the raw row size
+  TEST_ASSERT_TRUE(reader.size * 8U < NUM_ROWS * sizeof(struct archive_row));
+  archive_close_reader(&reader);
+}
+
+void test_truncated_block_ends_archive(void) {
+  TEST_ASSERT_TRUE(archive_open_writer(&writer_, path_));
+  for (size_t i = 0U; i < 2U * ARCHIVE_BLOCK_ROWS; ++i) {
+    const struct archive_row row = make_row(i);
+    TEST_ASSERT_TRUE(archive_append(&writer_, &row));
+  }
+  TEST_ASSERT_TRUE(archive_close_writer(&writer_));
+
+  struct stat st;
+  TEST_ASSERT_EQUAL_INT(0, stat(path_, &st));
+  TEST_ASSERT_EQUAL_INT(0, truncate(path_, st.st_size - 8));
+
+  struct archive_reader reader;
+  TEST_ASSERT_TRUE(archive_open_reader(&reader, path_));
+  TEST_ASSERT_NOT_NULL(archive_next_block(&reader));
+  TEST_ASSERT_NULL(archive_next_block(&reader));
+  archive_close_reader(&reader);
+}
+
+void test_append_after_truncated_block(void) {
+  TEST_ASSERT_TRUE(archive_open_writer(&writer_, path_));
+  for (size_t i = 0U; i < 2U * ARCHIVE_BLOCK_ROWS; ++i) {
+    expected_[i] = make_row(i);
+    TEST_ASSERT_TRUE(archive_append(&writer_, &expected_[i]));
+  }
+  TEST_ASSERT_TRUE(archive_close_writer(&writer_));
+  struct stat st;
+  TEST_ASSERT_EQUAL_INT(0, stat(path_, &st));
+  TEST_ASSERT_EQUAL_INT(0, truncate(path_, st.st_size - 8));
+
+  // the second block is lost, but the third follows the first
+  TEST_ASSERT_TRUE(archive_open_writer(&writer_, path_));
+  for (size_t i = ARCHIVE_BLOCK_ROWS; i < 2U * ARCHIVE_BLOCK_ROWS; ++i) {
+    TEST_ASSERT_TRUE(archive_append(&writer_, &expected_[i]));
+  }
+  TEST_ASSERT_TRUE(archive_close_writer(&writer_));
+  struct archive_reader reader;
+  TEST_ASSERT_TRUE(archive_open_reader(&reader, path_));
+  for (size_t block = 0U; block < 2U; ++block) {
+    const struct archive_block *b = archive_next_block(&reader);
+    TEST_ASSERT_NOT_NULL(b);
+    archive_decode_block(b, actual_);
+    assert_equal_rows(&expected_[block * ARCHIVE_BLOCK_ROWS], actual_,
+                      b->rows);
+  }
+  TEST_ASSERT_NULL(archive_next_block(&reader));
+  archive_close_reader(&reader);
+}
+
+// Writes an archive of two full blocks, and returns the offset of the second.
+static long write_two_blocks(void) {
+  remove(path_);
+  TEST_ASSERT_TRUE(archive_open_writer(&writer_, path_));
+  for (size_t i = 0U; i < 2U * ARCHIVE_BLOCK_ROWS; ++i) {
+    const struct archive_row row = make_row(i);
+    TEST_ASSERT_TRUE(archive_append(&writer_, &row));
+  }
+  TEST_ASSERT_TRUE(archive_close_writer(&writer_));
+  struct archive_reader reader;
+  TEST_ASSERT_TRUE(archive_open_reader(&reader, path_));
+  const struct archive_block *first = archive_next_block(&reader);
+  TEST_ASSERT_NOT_NULL(first);
+  const long offset = (long)(sizeof(struct archive_header) + first->size);
+  archive_close_reader(&reader);
+  return offset;
+}
+
+// Overwrites the file at the given offset.
+static void patch(const long offset, const void *data, const size_t size) {
+  FILE *file = fopen(path_, "r+b");
+  TEST_ASSERT_NOT_NULL(file);
+  TEST_ASSERT_EQUAL_INT(0, fseek(file, offset, SEEK_SET));
+  TEST_ASSERT_EQUAL_size_t(1U, fwrite(data, size, 1U, file));
+  TEST_ASSERT_EQUAL_INT(0, fclose(file));
+}
+
+// Reads the archive and returns the number of blocks.
+static size_t count_blocks(void) {
+  struct archive_reader reader;
+  TEST_ASSERT_TRUE(archive_open_reader(&reader, path_));
+  size_t blocks = 0U;
+  for (const struct archive_block *block = archive_next_block(&reader);
+       block != nullptr; block = archive_next_block(&reader)) {
+    archive_decode_block(block, actual_);
+    blocks += 1U;
+  }
+  archive_close_reader(&reader);
+  return blocks;
+}
+
+void test_corrupt_block_ends_archive(void) {
+  const long second = write_two_blocks();
+  TEST_ASSERT_EQUAL_size_t(2U, count_blocks());
+  // as the fields of the block header, and the first run of each column
+  const long size = second + (long)offsetof(struct archive_block, size);
+  const long runs = second + (long)offsetof(struct archive_block, runs);
+  const long deltas = second + (long)sizeof(struct archive_block);
+  const u32 zero = 0U;
+  const u32 huge = 0x7fffffffU;
+  const uint64_t huge_count = (uint64_t)1U << 40U;
+  const struct {
+    long offset;
+    const void *data;
+    size_t size;
+  } corruptions[] = {
+      {size, &zero, sizeof zero}, // would never advance
+      {size, &huge, sizeof huge},
+      {runs + (long)(COLUMN_READING * sizeof(u32)), &huge, sizeof huge},
+      {runs, &zero, sizeof zero}, // the timestamps take fewer rows
+      {deltas + (long)offsetof(struct archive_delta_run, count), &huge_count,
+       sizeof huge_count},
+  };
+  for (size_t i = 0U; i < sizeof corruptions / sizeof corruptions[0]; ++i) {
+    write_two_blocks();
+    patch(corruptions[i].offset, corruptions[i].data, corruptions[i].size);
+    TEST_ASSERT_EQUAL_size_t(1U, count_blocks());
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_truncated_block_ends_archive);
+  RUN_TEST(test_append_after_truncated_block);
+  RUN_TEST(test_corrupt_block_ends_archive);
+  return UNITY_END();
+}
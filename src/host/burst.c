@@ -0,0 +1,79 @@
+// Host-side decoder of the burst frames, see `burst_add()`.
+
+#include "../dou.h"
+
+#include <stddef.h>
+
+struct burst_frame {
+  u32 sequence;
+  u32 timestamp; // of the first reading
+  u32 span;      // from the first to the last reading
+  u32 readings[BURST_SIZE]; // packed words, as given by the decoder
+  size_t count;
+};
+
+// Parses one varint at `*src` and advances it. Returns false, if the varint is
+// malformed or longer than 32 bits.
+static bool parse_varint(const char **src, const char *end, u32 *value) {
+  *value = 0U;
+  for (unsigned shift = 0U; *src != end && shift < 32U;
+       shift += VARINT_BITS) {
+    const unsigned c = (unsigned)(unsigned char)**src - '0';
+    if (c >= 2U * VARINT_MORE) {
+      return false;
+    }
+    *src += 1;
+    *value |= (u32)(c & (VARINT_MORE - 1U)) << shift;
+    if ((c & VARINT_MORE) == 0U) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parse_char(const char **src, const char *end, const char c) {
+  if (*src == end || **src != c) {
+    return false;
+  }
+  *src += 1;
+  return true;
+}
+
+// Parses a burst frame, i.e. a line that starts with `#D` and ends with
+// `\r\n`. Returns false, if the line is not a well-formed burst frame.
+static bool parse_burst(const char *line, const size_t size,
+                        struct burst_frame *frame) {
+  const char *src = line;
+  const char *end = &line[size];
+  u32 reading;
+  if (!parse_char(&src, end, '#') || !parse_char(&src, end, 'D') ||
+      !parse_varint(&src, end, &frame->sequence) ||
+      !parse_char(&src, end, ' ') ||
+      !parse_varint(&src, end, &frame->timestamp) ||
+      !parse_char(&src, end, ' ') || !parse_varint(&src, end, &reading)) {
+    return false;
+  }
+  frame->readings[0] = reading;
+  frame->count = 1U;
+  while (src != end && *src != ' ') {
+    u32 zigzag;
+    if (frame->count == BURST_SIZE || !parse_varint(&src, end, &zigzag)) {
+      return false;
+    }
+    reading += (zigzag & 1U) != 0U ? ~(zigzag >> 1U) : zigzag >> 1U;
+    frame->readings[frame->count++] = reading;
+  }
+  return parse_char(&src, end, ' ') && parse_varint(&src, end, &frame->span) &&
+         parse_char(&src, end, '\r') && parse_char(&src, end, '\n') &&
+         src == end;
+}
+
+// Returns the timestamp of a reading of the frame, interpolated between the
+// first and the last one.
+static u32 burst_time(const struct burst_frame *frame, const size_t i) {
+  if (frame->count < 2U) {
+    return frame->timestamp;
+  }
+  return frame->timestamp +
+         (u32)((unsigned long long)frame->span * i / (frame->count - 1U));
+}
@@ -0,0 +1,243 @@
+// Benchmarks the host side of the serial link with the readings of the 8000A
+// sent one per line and in burst frames: the wakeups and CPU time of a reader
+// of a pseudo-terminal, and the latency of the readings.
+//
+// A child process plays the DOU and a USB-serial adapter. Once per period, the
+// reading is printed by `print_output()`, its characters arrive at the adapter
+// at the serial rate, and the adapter passes them on in chunks of up to
+// `CHUNK_SIZE` bytes, or when its latency timer expires after the first byte
+// of a chunk, like an FTDI chip with default settings. All times are divided
+// by `SPEED` to keep the benchmark short, but reported in real time.
+
+#define _XOPEN_SOURCE 700
+
+#include "../8000a.c"
+#include "burst.c"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PERIOD        0.16  // s, of nT
+#define PERIOD_TICKS  1920U // ACLK ticks
+#define LATENCY_TIMER 0.016 // s
+#define CHUNK_SIZE    62U   // bytes of a USB packet, less the status bytes
+#define SPEED         20.0
+#define NUM_READINGS  480U
+
+// start bit + data bits + stop bit
+#define SERIAL_CHAR_TIME ((SERIAL_DATA_BITS + 2.0) / SERIAL_BAUD_RATE)
+
+struct mode {
+  const char *name;
+  u8 format;
+  u8 burst_size;
+  u8 burst_deadline;
+};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double cpu_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void sleep_until(const double time) {
+  const struct timespec ts = {(time_t)time,
+                              (long)((time - (double)(time_t)time) * 1e9)};
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+         EINTR) {
+  }
+}
+
+// Returns the next reading, which wanders by a count at most.
+static unsigned next_reading(unsigned *value) {
+  *value = (*value + 999U + (unsigned)(rand() % 3)) % 1000U;
+  return 0x7000U | (*value / 100U) << 8U | (*value / 10U % 10U) << 4U |
+         *value % 10U;
+}
+
+struct adapter {
+  int fd;
+  double epoch;
+  char chunk[CHUNK_SIZE];
+  size_t size;
+  double first; // arrival of the first byte of the chunk
+};
+
+static void adapter_flush(struct adapter *a, const double time) {
+  if (a->size > 0U) {
+    sleep_until(a->epoch + time / SPEED);
+    if (write(a->fd, a->chunk, a->size) != (ssize_t)a->size) {
+      perror("write");
+    }
+    a->size = 0U;
+  }
+}
+
+static void adapter_receive(struct adapter *a, const char c,
+                            const double time) {
+  if (a->size > 0U && time > a->first + LATENCY_TIMER) {
+    adapter_flush(a, a->first + LATENCY_TIMER);
+  }
+  if (a->size == 0U) {
+    a->first = time;
+  }
+  a->chunk[a->size++] = c;
+  if (a->size == CHUNK_SIZE) {
+    adapter_flush(a, time);
+  }
+}
+
+static void run_dou(const struct mode *mode, const int fd,
+                    const double epoch) {
+  struct config config = {CONFIG_MAGIC,     mode->format, 0U, 0U, 0U,
+                          mode->burst_size, mode->burst_deadline, 0U};
+  struct si_average average = {0, 0U, false, {0, 0, SI_NONE}};
+  struct burst burst = {0U, 0U, 0U, 0U, 0U};
+  struct adapter adapter = {fd, epoch, {0}, 0U, 0.0};
+  char buf[MAX_OUTPUT_SIZE];
+  double line_free = 0.0; // the serial line is busy until then
+  unsigned value = 500U;
+  u16 sequence = 0U;
+  srand(44);
+  for (unsigned i = 0U; i < NUM_READINGS; ++i) {
+    const unsigned reading = next_reading(&value);
+    bool complete = print_output(buf, &config, &average, &burst, reading,
+                                 false, sequence, i * PERIOD_TICKS);
+    if (i + 1U == NUM_READINGS && !complete && burst.count > 0U) {
+      burst_finish(buf, &burst);
+      complete = true;
+    }
+    if (!complete) {
+      continue;
+    }
+    sequence += 1U;
+    const double start = i * PERIOD > line_free ? i * PERIOD : line_free;
+    const size_t size = strlen(buf);
+    for (size_t k = 0U; k < size; ++k) {
+      adapter_receive(&adapter, buf[k],
+                      start + (double)(k + 1U) * SERIAL_CHAR_TIME);
+    }
+    line_free = start + (double)size * SERIAL_CHAR_TIME;
+  }
+  adapter_flush(&adapter, adapter.first + LATENCY_TIMER);
+}
+
+struct result {
+  size_t readings;
+  size_t bytes;
+  size_t wakeups;
+  double cpu;
+  double latency_sum;
+  double latency_max;
+};
+
+static void received(struct result *r, const double epoch, const double t) {
+  const double latency = (t - epoch) * SPEED - (double)r->readings * PERIOD;
+  r->latency_sum += latency;
+  r->latency_max = latency > r->latency_max ? latency : r->latency_max;
+  r->readings += 1U;
+}
+
+static void run_host(struct result *r, const int fd, const double epoch) {
+  static char text[4096];
+  size_t size = 0U;
+  const double start = cpu_time();
+  while (r->readings < NUM_READINGS) {
+    const ssize_t n = read(fd, &text[size], sizeof text - size);
+    if (n <= 0) {
+      break;
+    }
+    const double t = now();
+    r->wakeups += 1U;
+    r->bytes += (size_t)n;
+    size += (size_t)n;
+    char *line = text;
+    for (char *end; (end = memchr(line, '\n', size - (size_t)(line - text)));
+         line = end + 1) {
+      struct burst_frame frame;
+      const size_t line_size = (size_t)(end - line) + 1U;
+      if (line[0] != '#') {
+        received(r, epoch, t);
+      } else if (parse_burst(line, line_size, &frame)) {
+        for (size_t i = 0U; i < frame.count; ++i) {
+          received(r, epoch, t);
+        }
+      }
+    }
+    size -= (size_t)(line - text);
+    memmove(text, line, size);
+  }
+  r->cpu = cpu_time() - start;
+}
+
+static bool bench(const struct mode *mode) {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    perror("pty");
+    return false;
+  }
+  const int slave = open(ptsname(master), O_RDONLY | O_NOCTTY);
+  struct termios tio;
+  if (slave < 0 || tcgetattr(slave, &tio) != 0) {
+    perror("pty");
+    return false;
+  }
+  // pass the bytes through as they are, and wake the reader for each chunk
+  tio.c_iflag = 0U;
+  tio.c_oflag = 0U;
+  tio.c_lflag = 0U;
+  tio.c_cc[VMIN] = 1U;
+  tio.c_cc[VTIME] = 0U;
+  tcsetattr(slave, TCSANOW, &tio);
+
+  const double epoch = now() + 0.1;
+  const pid_t pid = fork();
+  if (pid == 0) {
+    close(slave);
+    run_dou(mode, master, epoch);
+    sleep_until(now() + 0.1); // closing the pty discards what was not read
+    _exit(EXIT_SUCCESS);
+  }
+  close(master);
+  struct result r = {0U, 0U, 0U, 0.0, 0.0, 0.0};
+  run_host(&r, slave, epoch);
+  close(slave);
+  waitpid(pid, nullptr, 0);
+
+  const double n = (double)r.readings;
+  printf("%-12s %5.2f bytes, %5.3f wakeups, %5.2f us CPU per reading, "
+         "latency %5.1f ms mean, %5.1f ms max\n",
+         mode->name, (double)r.bytes / n, (double)r.wakeups / n,
+         r.cpu / n * 1e6, r.latency_sum / n * 1e3, r.latency_max * 1e3);
+  return r.readings == NUM_READINGS;
+}
+
+int main(void) {
+  static const struct mode modes[] = {
+      {"lines", FORMAT_FIXED, BURST_SIZE, 0U},
+      {"burst N4", FORMAT_BURST, 4U, 0U},
+      {"burst N16", FORMAT_BURST, 16U, 0U},
+      {"burst D5", FORMAT_BURST, BURST_SIZE, 5U},
+  };
+  bool ok = true;
+  for (size_t i = 0U; i < sizeof modes / sizeof modes[0]; ++i) {
+    ok = bench(&modes[i]) && ok;
+  }
+  if (!ok) {
+    printf("readings missing\n");
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
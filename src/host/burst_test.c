@@ -0,0 +1,99 @@
+// Tests the burst frames from the encoder of the firmware to the host decoder.
+
+#include "../dou.c"
+#include "burst.c"
+
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_varint(void) {
+  static const u32 values[] = {0U, 31U, 32U, 1023U, 1024U, 0xffffffffU};
+  for (size_t i = 0U; i < sizeof values / sizeof values[0]; ++i) {
+    char buf[MAX_VARINT_SIZE];
+    const char *end = print_varint(buf, &buf[MAX_VARINT_SIZE], values[i]);
+    const char *src = buf;
+    u32 value;
+    TEST_ASSERT_TRUE(parse_varint(&src, end, &value));
+    TEST_ASSERT_EQUAL_PTR(end, src);
+    TEST_ASSERT_EQUAL_HEX32(values[i], value);
+  }
+  char buf[MAX_VARINT_SIZE];
+  TEST_ASSERT_EQUAL_PTR(&buf[1], print_varint(buf, &buf[1], 31U));
+  TEST_ASSERT_EQUAL_CHAR('O', buf[0]);
+}
+
+void test_round_trip(void) {
+  // small steps, a wrap of the digits and a change of the held flag
+  static const u32 readings[] = {0x7123U, 0x7124U, 0x7122U, 0x7122U,
+                                 0x7999U, 0x0000U, 0x1b999U, 0xb999U};
+  const size_t count = sizeof readings / sizeof readings[0];
+  char buf[MAX_BURST_SIZE];
+  struct burst b = {0U, 0U, 0U, 0U, 0U};
+  for (size_t i = 0U; i < count; ++i) {
+    TEST_ASSERT_FALSE(
+        burst_add(buf, &b, readings[i], 42U, 1000U + 2000U * (u32)i,
+                  BURST_SIZE, 0U));
+  }
+  burst_finish(buf, &b);
+  struct burst_frame frame;
+  TEST_ASSERT_TRUE(parse_burst(buf, strlen(buf), &frame));
+  TEST_ASSERT_EQUAL_UINT32(42U, frame.sequence);
+  TEST_ASSERT_EQUAL_size_t(count, frame.count);
+  TEST_ASSERT_EQUAL_HEX32_ARRAY(readings, frame.readings, count);
+  TEST_ASSERT_EQUAL_UINT32(1000U, burst_time(&frame, 0U));
+  TEST_ASSERT_EQUAL_UINT32(7000U, burst_time(&frame, 3U));
+  TEST_ASSERT_EQUAL_UINT32(15000U, burst_time(&frame, count - 1U));
+  // small steps take one character each, the jumps three or four
+  TEST_ASSERT_EQUAL_STRING("#DZ1 XO SYL230^W4ail1bil6ooo3 `e=\r\n", buf);
+}
+
+void test_full_frames(void) {
+  srand(43);
+  char buf[MAX_BURST_SIZE];
+  struct burst b = {0U, 0U, 0U, 0U, 0U};
+  u32 readings[BURST_SIZE];
+  size_t count = 0U;
+  for (int i = 0; i < 1000; ++i) {
+    // mostly small steps, now and then any word at all
+    const u32 reading = rand() % 8 == 0
+                            ? (u32)rand() << 16U ^ (u32)rand()
+                            : readings[count > 0U ? count - 1U : 0U] +
+                                  (u32)(rand() % 64) - 32U;
+    readings[count++] = reading;
+    if (burst_add(buf, &b, reading, (u16)i, (u32)i * 1920U, BURST_SIZE, 0U)) {
+      struct burst_frame frame;
+      TEST_ASSERT_LESS_THAN_size_t(MAX_BURST_SIZE, strlen(buf));
+      TEST_ASSERT_TRUE(parse_burst(buf, strlen(buf), &frame));
+      TEST_ASSERT_EQUAL_size_t(count, frame.count);
+      TEST_ASSERT_EQUAL_HEX32_ARRAY(readings, frame.readings, count);
+      readings[0] = readings[count - 1U];
+      count = 0U;
+    }
+  }
+}
+
+void test_malformed(void) {
+  struct burst_frame frame;
+  TEST_ASSERT_TRUE(parse_burst("#D3 T3 i\\^1 0\r\n", 15U, &frame));
+  TEST_ASSERT_EQUAL_HEX32(0xb999U, frame.readings[0]);
+  TEST_ASSERT_FALSE(parse_burst("#D3 T3 i\\^1 0\r", 14U, &frame));
+  TEST_ASSERT_FALSE(parse_burst("#D3 T3 i\\^1\r\n", 13U, &frame));
+  TEST_ASSERT_FALSE(parse_burst("#D3 T3 i\\^ 0\r\n", 14U, &frame));
+  TEST_ASSERT_FALSE(parse_burst("#D3 T3 i\\^1 0x\r\n", 16U, &frame));
+  TEST_ASSERT_FALSE(parse_burst(" +1213\r\n", 8U, &frame));
+  TEST_ASSERT_FALSE(parse_burst("#Doooooooo 0 0 0\r\n", 18U, &frame));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_varint);
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_full_frames);
+  RUN_TEST(test_malformed);
+  return UNITY_END();
+}
@@ -0,0 +1,28 @@
+// Host-side validation of the frame check trailer, see `SERIAL_FRAME_CHECK`.
+
+#include "../dou.h"
+
+#include <stddef.h>
+
+// Checks the trailer of a line that ends with `\r\n` and removes it, so that
+// the line looks as if frame checks were disabled. Returns the new size of the
+// line, or 0, if the line lacks a trailer or its checksum does not match.
+static size_t frame_check_strip(char *line, const size_t size) {
+  if (size < FRAME_CHECK_SIZE + 2U || line[size - 2U] != '\r' ||
+      line[size - 1U] != '\n') {
+    return 0U;
+  }
+  const size_t payload_size = size - 2U - FRAME_CHECK_SIZE;
+  u8 crc = 0U;
+  for (size_t i = 0U; i < payload_size; ++i) {
+    crc = frame_check_update(crc, line[i]);
+  }
+  const char *trailer = &line[payload_size];
+  if (trailer[0] != FRAME_CHECK_MARKER || trailer[1] != hex_digit(crc >> 4U) ||
+      trailer[2] != hex_digit(crc)) {
+    return 0U;
+  }
+  line[payload_size] = '\r';
+  line[payload_size + 1U] = '\n';
+  return payload_size + 2U;
+}
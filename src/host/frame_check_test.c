@@ -0,0 +1,70 @@
+// Tests the frame check trailer as sent by the firmware.
+
+#include "../dou.c"
+#include "frame_check.c"
+
+#include <unity.h>
+
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Builds the frame the same way `send_serial()` does.
+static size_t make_frame(char *frame, const char *msg) {
+  size_t size = 0U;
+  u8 crc = 0U;
+  for (; *msg != '\0'; ++msg) {
+    if (*msg == '\r') {
+      frame[size++] = FRAME_CHECK_MARKER;
+      frame[size++] = hex_digit(crc >> 4U);
+      frame[size++] = hex_digit(crc);
+    }
+    crc = frame_check_update(crc, *msg);
+    frame[size++] = *msg;
+  }
+  frame[size] = '\0';
+  return size;
+}
+
+void test_crc(void) {
+  // the check value of CRC-8 (poly 0x07, init 0)
+  u8 crc = 0U;
+  for (const char *c = "123456789"; *c != '\0'; ++c) {
+    crc = frame_check_update(crc, *c);
+  }
+  TEST_ASSERT_EQUAL_HEX8(0xf4U, crc);
+}
+
+void test_valid_frame_is_stripped(void) {
+  char frame[32];
+  const size_t size = make_frame(frame, " +1234\r\n");
+  TEST_ASSERT_EQUAL_STRING(" +1234*22\r\n", frame);
+  TEST_ASSERT_EQUAL_size_t(8U, frame_check_strip(frame, size));
+  TEST_ASSERT_EQUAL_MEMORY(" +1234\r\n", frame, 8U);
+}
+
+void test_corruption_is_detected(void) {
+  char frame[32];
+  const size_t size = make_frame(frame, " 001.234MHz\r\n");
+  // flip every single bit of the 7 bit characters, one at a time
+  for (size_t i = 0U; i < size - 2U; ++i) {
+    for (unsigned bit = 0U; bit < 7U; ++bit) {
+      char corrupted[32];
+      memcpy(corrupted, frame, size);
+      corrupted[i] = (char)((unsigned)corrupted[i] ^ (1U << bit));
+      TEST_ASSERT_EQUAL_size_t(0U, frame_check_strip(corrupted, size));
+    }
+  }
+  TEST_ASSERT_EQUAL_size_t(0U, frame_check_strip(frame, size - 1U));
+  char plain[] = " +1234\r\n";
+  TEST_ASSERT_EQUAL_size_t(0U, frame_check_strip(plain, sizeof plain - 1U));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc);
+  RUN_TEST(test_valid_frame_is_stripped);
+  RUN_TEST(test_corruption_is_detected);
+  return UNITY_END();
+}
@@ -0,0 +1,33 @@
+// Filters DOU output with frame checks enabled: valid readings are passed on
+// without their trailer, so that existing consumers can process them, while
+// corrupted ones are dropped and counted on stderr.
+
+#include "../dou.c"
+#include "frame_check.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(void) {
+  static char line[256];
+  unsigned long long valid = 0U;
+  unsigned long long invalid = 0U;
+  while (fgets(line, sizeof line, stdin) != nullptr) {
+    size_t size = strlen(line);
+    if (size == 0U || line[size - 1U] != '\n') {
+      invalid += 1U; // overlong or cut short
+      continue;
+    }
+    size = frame_check_strip(line, size);
+    if (size == 0U) {
+      invalid += 1U;
+      continue;
+    }
+    fwrite(line, 1U, size, stdout);
+    fflush(stdout);
+    valid += 1U;
+  }
+  fprintf(stderr, "%llu valid, %llu invalid\n", valid, invalid);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,217 @@
+// Decodes long logic captures of the bus on all cores.
+//
+// A capture is a sequence of `struct capture_edge`, i.e. the `INPUT_*` word
+// after each change and its time, as recorded by a logic analyzer. It is split
+// into one chunk per thread at boundaries, where the meter starts over, i.e.
+// the rising edge of T (8000A) or nMUP (1900A). Each chunk is decoded from the
+// reset state, as if it were the start of the capture, and the readings are
+// merged in order, each with the time of the edge that completed it.
+//
+// The decoder does not always start over at a boundary, e.g. the 8000A holds
+// an overload reading for the blank period of the flashing display. So the
+// merge checks whether a chunk started from the state that its predecessor
+// ended with. If not, the chunk is decoded again from that state up to its
+// next boundary. If the states agree there, only the readings before are
+// replaced, otherwise the whole chunk is decoded again. The result is always
+// that of `offline_decode_sequential()`.
+//
+// The meter provides the hooks below, see `offline_8000a.c` and
+// `offline_1900a.c`.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <threads.h>
+
+struct capture_edge {
+  uint64_t time;
+  unsigned input; // after the edge
+};
+
+struct offline_reading {
+  uint64_t time; // of the edge that completed the reading
+  u32 word;      // the packed reading, as for the burst format
+};
+
+// The state of the decoder at the start of a capture.
+static struct decoder_state offline_reset(void);
+
+static bool offline_same(struct decoder_state a, struct decoder_state b);
+
+// Returns true, if the meter starts over with this edge.
+static bool offline_boundary(unsigned previous, unsigned input);
+
+// Decodes the edge, if the firmware would. Returns true and the packed word,
+// if a reading is complete, and prepares the state for the next one.
+static bool offline_step(struct decoder_state *state, unsigned previous,
+                         unsigned input, u32 *word);
+
+struct offline_readings {
+  struct offline_reading *readings;
+  size_t count;
+  size_t capacity;
+};
+
+static bool offline_append(struct offline_readings *r, const uint64_t time,
+                           const u32 word) {
+  if (r->count == r->capacity) {
+    const size_t capacity = r->capacity ? 2U * r->capacity : 1024U;
+    struct offline_reading *readings =
+        realloc(r->readings, capacity * sizeof readings[0]);
+    if (readings == nullptr) {
+      return false;
+    }
+    r->readings = readings;
+    r->capacity = capacity;
+  }
+  r->readings[r->count++] = (struct offline_reading){time, word};
+  return true;
+}
+
+struct offline_chunk {
+  const struct capture_edge *edges;
+  size_t begin;
+  size_t end;
+  size_t sync;         // the first boundary after `begin`, or `end`
+  size_t sync_count;   // readings before `sync`
+  struct decoder_state start;
+  struct decoder_state sync_state;
+  struct decoder_state state; // at the end
+  struct offline_readings out;
+  bool ok;
+};
+
+// Decodes the edges from `begin` to `end` from `*state` and appends the
+// readings to `out`.
+static bool offline_run(const struct capture_edge *edges, const size_t begin,
+                        const size_t end, struct decoder_state *state,
+                        struct offline_readings *out) {
+  unsigned previous = begin > 0U ? edges[begin - 1U].input : 0U;
+  for (size_t i = begin; i < end; ++i) {
+    const unsigned input = edges[i].input;
+    u32 word;
+    if (offline_step(state, previous, input, &word) &&
+        !offline_append(out, edges[i].time, word)) {
+      return false;
+    }
+    previous = input;
+  }
+  return true;
+}
+
+static int offline_worker(void *arg) {
+  struct offline_chunk *c = arg;
+  struct decoder_state state = c->start;
+  c->ok = offline_run(c->edges, c->begin, c->sync, &state, &c->out);
+  c->sync_count = c->out.count;
+  c->sync_state = state;
+  c->ok = c->ok && offline_run(c->edges, c->sync, c->end, &state, &c->out);
+  c->state = state;
+  return 0;
+}
+
+// Returns the index of the first boundary at or after `i`, or `end`.
+static size_t offline_find_boundary(const struct capture_edge *edges,
+                                    size_t i, const size_t end) {
+  for (; i < end; ++i) {
+    if (i > 0U && offline_boundary(edges[i - 1U].input, edges[i].input)) {
+      return i;
+    }
+  }
+  return end;
+}
+
+// Decodes the chunk again from the state that its predecessor ended with.
+static bool offline_resync(struct offline_chunk *c,
+                           const struct decoder_state start) {
+  struct offline_readings head = {nullptr, 0U, 0U};
+  struct decoder_state state = start;
+  bool ok = offline_run(c->edges, c->begin, c->sync, &state, &head);
+  if (ok && offline_same(state, c->sync_state)) {
+    // converged, so only the readings before `sync` differ
+    const size_t tail = c->out.count - c->sync_count;
+    for (size_t i = 0U; ok && i < tail; ++i) {
+      const struct offline_reading *r = &c->out.readings[c->sync_count + i];
+      ok = offline_append(&head, r->time, r->word);
+    }
+  } else if (ok) {
+    ok = offline_run(c->edges, c->sync, c->end, &state, &head);
+    c->state = state;
+  }
+  free(c->out.readings);
+  c->out = head;
+  c->start = start;
+  return ok;
+}
+
+// Decodes the capture like the firmware does, one edge after the other.
+static bool offline_decode_sequential(const struct capture_edge *edges,
+                                      const size_t length,
+                                      struct offline_readings *out) {
+  struct decoder_state state = offline_reset();
+  return offline_run(edges, 0U, length, &state, out);
+}
+
+// Decodes the capture in up to `num_threads` chunks in parallel. The readings
+// are appended to `out`, which the caller frees.
+static bool offline_decode(const struct capture_edge *edges,
+                           const size_t length, size_t num_threads,
+                           struct offline_readings *out) {
+  if (num_threads < 1U) {
+    num_threads = 1U;
+  }
+  struct offline_chunk *chunks = calloc(num_threads, sizeof chunks[0]);
+  thrd_t *threads = calloc(num_threads, sizeof threads[0]);
+  if (chunks == nullptr || threads == nullptr) {
+    free(chunks);
+    free(threads);
+    return false;
+  }
+  // the split points are moved on to the next boundary
+  size_t num_chunks = 0U;
+  for (size_t begin = 0U; begin < length && num_chunks < num_threads;) {
+    const size_t even = length / num_threads * (num_chunks + 1U);
+    const size_t end =
+        num_chunks + 1U == num_threads
+            ? length
+            : offline_find_boundary(edges, even > begin ? even : begin + 1U,
+                                    length);
+    struct offline_chunk *c = &chunks[num_chunks++];
+    c->edges = edges;
+    c->begin = begin;
+    c->end = end;
+    c->sync = offline_find_boundary(edges, begin + 1U, end);
+    c->start = offline_reset();
+    begin = end;
+  }
+
+  bool ok = true;
+  size_t num_started = 0U;
+  for (; num_started < num_chunks; ++num_started) {
+    if (thrd_create(&threads[num_started], offline_worker,
+                    &chunks[num_started]) != thrd_success) {
+      ok = false;
+      break;
+    }
+  }
+  for (size_t i = 0U; i < num_started; ++i) {
+    thrd_join(threads[i], nullptr);
+    ok = ok && chunks[i].ok;
+  }
+
+  for (size_t i = 0U; ok && i < num_chunks; ++i) {
+    struct offline_chunk *c = &chunks[i];
+    if (i > 0U && !offline_same(c->start, chunks[i - 1U].state)) {
+      ok = offline_resync(c, chunks[i - 1U].state);
+    }
+    for (size_t j = 0U; ok && j < c->out.count; ++j) {
+      ok = offline_append(out, c->out.readings[j].time,
+                          c->out.readings[j].word);
+    }
+  }
+  for (size_t i = 0U; i < num_chunks; ++i) {
+    free(chunks[i].out.readings);
+  }
+  free(chunks);
+  free(threads);
+  return ok;
+}
@@ -0,0 +1,56 @@
+// The hooks of the offline decoder for the 1900A, see `offline.c`. Edges are
+// decoded like `sim_capture()` does.
+
+#include "../1900a_sim.c"
+#include "offline.c"
+
+static struct decoder_state offline_reset(void) {
+  return (struct decoder_state){0U, 0, 0};
+}
+
+static bool offline_same(const struct decoder_state a,
+                         const struct decoder_state b) {
+  return a.reading == b.reading && a.next_digit == b.next_digit &&
+         a.decimal_point_digit == b.decimal_point_digit;
+}
+
+// The display is scanned afresh with the rising edge of nMUP.
+static bool offline_boundary(const unsigned previous, const unsigned input) {
+  return (input & ~previous & INPUT_nMUP) != 0U;
+}
+
+static bool offline_step(struct decoder_state *state, const unsigned previous,
+                         const unsigned input, u32 *word) {
+  const unsigned rising = input & ~previous;
+  const unsigned falling = previous & ~input;
+  if ((rising & (INPUT_AS6 | INPUT_AS5 | INPUT_AS4 | INPUT_AS3 | INPUT_AS2 |
+                 INPUT_AS1)) == 0U &&
+      (falling & INPUT_nMUP) == 0U) {
+    return false;
+  }
+  *state = decode(*state, input);
+  if (state->next_digit <= NUMBER_OF_DIGITS) {
+    return false;
+  }
+  const enum unit unit =
+      determine_unit((input & INPUT_NML) != 0U, (input & INPUT_RNG2) != 0U,
+                     state->decimal_point_digit != 0);
+  *word = state->reading | ((input & INPUT_OVFL) != 0U ? BURST_OVERFLOW : 0U) |
+          BURST_UNIT(unit);
+  *state = (struct decoder_state){0U, UPDATE_END, 0};
+  return true;
+}
+
+static char *offline_print(char buf[static MAX_READING_SIZE], const u32 word) {
+  // the decimal point is the only nibble that is not a BCD digit
+  const u32 reading = word & (BURST_UNIT(7U) - 1U);
+  int decimal_point_digit = 0;
+  for (int i = 0; i <= NUMBER_OF_DIGITS; ++i) {
+    if (DIGIT(reading, i) == DECIMAL_POINT_BCD) {
+      decimal_point_digit = NUMBER_OF_DIGITS + 1 - i;
+    }
+  }
+  return print_reading(buf, reading, decimal_point_digit,
+                       (word & BURST_OVERFLOW) != 0U,
+                       (enum unit)(word >> 28U & 7U));
+}
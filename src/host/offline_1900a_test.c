@@ -0,0 +1,88 @@
+// Tests the parallel offline decoder against the sequential one on 1900A
+// captures.
+
+#include "offline_1900a.c"
+
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static struct sim sim_;
+static struct capture_edge edges_[SIM_MAX_STEPS];
+
+// Converts the simulated steps to a capture, in µs.
+static size_t capture_sim(void) {
+  uint64_t time = 0U;
+  for (size_t i = 0U; i < sim_.length; ++i) {
+    edges_[i] = (struct capture_edge){time, sim_.steps[i].input};
+    time += sim_.steps[i].duration;
+  }
+  return sim_.length;
+}
+
+void test_readings(void) {
+  const struct sim_display first = {0x123456U, 3, INPUT_NML};
+  const struct sim_display second = {0x000042U, 0, INPUT_OVFL};
+  sim_.length = 0U;
+  sim_gate(&sim_, &first, &second, 10000U);
+  sim_gate(&sim_, &second, &first, 10000U);
+  sim_scan(&sim_, &first, INPUT_nMUP);
+  const size_t length = capture_sim();
+
+  struct offline_readings readings = {nullptr, 0U, 0U};
+  TEST_ASSERT_TRUE(offline_decode(edges_, length, 2U, &readings));
+  TEST_ASSERT_EQUAL_size_t(2U, readings.count);
+  // printed as the firmware does
+  char expected[2U * MAX_READING_SIZE];
+  sim_capture(&sim_, false, expected);
+  char text[2U * MAX_READING_SIZE];
+  offline_print(offline_print(text, readings.readings[0].word),
+                readings.readings[1].word);
+  TEST_ASSERT_EQUAL_STRING(expected, text);
+  // completed by the rising edge of AS1 in the first scan of the update
+  const uint64_t scans = (10000U + SIM_SCAN_US - 1U) / SIM_SCAN_US;
+  TEST_ASSERT_EQUAL_UINT64(
+      scans * SIM_SCAN_US + (NUMBER_OF_DIGITS - 1) * SIM_DIGIT_US +
+          SIM_SETUP_US,
+      readings.readings[0].time);
+  free(readings.readings);
+}
+
+void test_parallel(void) {
+  srand(1945);
+  sim_.length = 0U;
+  struct sim_display display = {0U, 0, 0U};
+  while (sim_.length + 1024U <= SIM_MAX_STEPS) {
+    const struct sim_display next = {(u32)rand() & 0x999999U,
+                                     rand() % (NUMBER_OF_DIGITS + 1),
+                                     (unsigned)rand() & INPUT_OVFL};
+    sim_gate(&sim_, &display, &next, 10000U);
+    display = next;
+  }
+  const size_t length = capture_sim();
+  struct offline_readings expected = {nullptr, 0U, 0U};
+  TEST_ASSERT_TRUE(offline_decode_sequential(edges_, length, &expected));
+  TEST_ASSERT_EQUAL_size_t(sim_capture(&sim_, false, nullptr),
+                           expected.count);
+  for (size_t threads = 1U; threads <= 256U; threads *= 4U) {
+    struct offline_readings actual = {nullptr, 0U, 0U};
+    TEST_ASSERT_TRUE(offline_decode(edges_, length, threads, &actual));
+    TEST_ASSERT_EQUAL_size_t(expected.count, actual.count);
+    for (size_t i = 0U; i < expected.count; ++i) {
+      TEST_ASSERT_EQUAL_UINT64(expected.readings[i].time,
+                               actual.readings[i].time);
+      TEST_ASSERT_EQUAL_HEX32(expected.readings[i].word,
+                              actual.readings[i].word);
+    }
+    free(actual.readings);
+  }
+  free(expected.readings);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings);
+  RUN_TEST(test_parallel);
+  return UNITY_END();
+}
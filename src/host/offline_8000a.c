@@ -0,0 +1,39 @@
+// The hooks of the offline decoder for the 8000A, see `offline.c`. Edges are
+// decoded like `run_capture()` in `8000a_test.c` does without the filter.
+
+#include "../8000a_sim.c"
+#include "offline.c"
+
+static struct decoder_state offline_reset(void) {
+  return (struct decoder_state){0U, 0};
+}
+
+static bool offline_same(const struct decoder_state a,
+                         const struct decoder_state b) {
+  return a.reading == b.reading && a.next_digit == b.next_digit;
+}
+
+// The meter starts its update with the rising edge of T.
+static bool offline_boundary(const unsigned previous, const unsigned input) {
+  return (input & ~previous & INPUT_T) != 0U;
+}
+
+static bool offline_step(struct decoder_state *state, const unsigned previous,
+                         const unsigned input, u32 *word) {
+  const unsigned changes = input ^ previous;
+  if ((changes & INPUT_T) == 0U && (changes & input & INPUT_S) == 0U) {
+    return false;
+  }
+  *state = decode(*state, input);
+  if (state->next_digit <= NUMBER_OF_DIGITS) {
+    return false;
+  }
+  *word = state->reading |
+          (state->next_digit == BLANK_PERIOD ? BURST_HELD : 0U);
+  *state = decode_next(*state);
+  return true;
+}
+
+static char *offline_print(char buf[static MAX_READING_SIZE], const u32 word) {
+  return print_reading(buf, word & ~BURST_HELD, (word & BURST_HELD) != 0U);
+}
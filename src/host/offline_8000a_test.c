@@ -0,0 +1,92 @@
+// Tests the parallel offline decoder against the sequential one on 8000A
+// captures.
+
+#include "offline_8000a.c"
+
+#include <unity.h>
+
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define NUM_BATCHES 64
+
+static struct sim sim_;
+static struct capture_edge edges_[NUM_BATCHES * SIM_MAX_TICKS];
+static size_t length_;
+
+// Appends the changes of the simulated inputs to the capture, in ticks.
+static void append_sim(const uint64_t start) {
+  for (size_t t = 0U; t < sim_.length; ++t) {
+    if (length_ == 0U || edges_[length_ - 1U].input != sim_.inputs[t]) {
+      edges_[length_++] = (struct capture_edge){start + t, sim_.inputs[t]};
+    }
+  }
+}
+
+static void assert_same(const struct offline_readings *expected,
+                        const struct offline_readings *actual) {
+  TEST_ASSERT_EQUAL_size_t(expected->count, actual->count);
+  for (size_t i = 0U; i < expected->count; ++i) {
+    TEST_ASSERT_EQUAL_UINT64(expected->readings[i].time,
+                             actual->readings[i].time);
+    TEST_ASSERT_EQUAL_HEX32(expected->readings[i].word,
+                            actual->readings[i].word);
+  }
+}
+
+void test_readings(void) {
+  static const unsigned digits[] = {0x6U, 0x1U, 0x2U, 0x3U};
+  length_ = 0U;
+  sim_.length = 0U;
+  sim_period(&sim_, digits);
+  sim_period(&sim_, digits);
+  append_sim(0U);
+  struct offline_readings readings = {nullptr, 0U, 0U};
+  TEST_ASSERT_TRUE(offline_decode(edges_, length_, 2U, &readings));
+  TEST_ASSERT_EQUAL_size_t(2U, readings.count);
+  char text[MAX_READING_SIZE];
+  offline_print(text, readings.readings[1].word);
+  TEST_ASSERT_EQUAL_STRING(" + 123\r\n", text);
+  // completed by the rising edge of S with S4
+  TEST_ASSERT_EQUAL_UINT64(sim_strobe_tick(SIM_PERIOD_TICKS, 3),
+                           readings.readings[1].time);
+  free(readings.readings);
+}
+
+void test_parallel(void) {
+  // periods of all kinds, so that overload readings are held across splits
+  static const unsigned normal[] = {0x6U, 0x1U, 0x2U, 0x3U};
+  static const unsigned overload[] = {0xbU, 0x9U, 0x9U, 0x9U};
+  srand(45);
+  length_ = 0U;
+  for (int batch = 0; batch < NUM_BATCHES; ++batch) {
+    sim_.length = 0U;
+    while (sim_.length + 2U * SIM_PERIOD_TICKS <= SIM_MAX_TICKS) {
+      if (rand() % 2 == 0) {
+        sim_period(&sim_, normal);
+      } else {
+        sim_period(&sim_, overload);
+        sim_period(&sim_, nullptr);
+      }
+    }
+    append_sim((uint64_t)batch * SIM_MAX_TICKS);
+  }
+  struct offline_readings expected = {nullptr, 0U, 0U};
+  TEST_ASSERT_TRUE(offline_decode_sequential(edges_, length_, &expected));
+  for (size_t threads = 1U; threads <= 256U; threads *= 4U) {
+    struct offline_readings actual = {nullptr, 0U, 0U};
+    TEST_ASSERT_TRUE(offline_decode(edges_, length_, threads, &actual));
+    assert_same(&expected, &actual);
+    free(actual.readings);
+  }
+  free(expected.readings);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings);
+  RUN_TEST(test_parallel);
+  return UNITY_END();
+}
@@ -0,0 +1,88 @@
+// Benchmarks the offline decoder on a simulated 1900A capture of more than an
+// hour with up to one thread per core, but at least four, and checks that the
+// readings are those of the sequential decoder.
+
+#define _XOPEN_SOURCE 700
+
+#include "offline_1900a.c"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GATE_US    10000U // the shortest gate time, 10 ms
+#define NUM_COPIES 64U    // of the simulation in the capture
+
+static double seconds_since(const struct timespec *start) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  return (double)(now.tv_sec - start->tv_sec) +
+         (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static bool same(const struct offline_readings *a,
+                 const struct offline_readings *b) {
+  if (a->count != b->count) {
+    return false;
+  }
+  for (size_t i = 0U; i < a->count; ++i) {
+    if (a->readings[i].time != b->readings[i].time ||
+        a->readings[i].word != b->readings[i].word) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static struct sim sim_;
+
+int main(void) {
+  srand(1900);
+  struct sim_display display = {0U, 0, 0U};
+  while (sim_.length + 1024U <= SIM_MAX_STEPS) {
+    const struct sim_display next = {(u32)rand() & 0x999999U,
+                                     rand() % (NUMBER_OF_DIGITS + 1),
+                                     (unsigned)rand() & INPUT_OVFL};
+    sim_gate(&sim_, &display, &next, GATE_US);
+    display = next;
+  }
+  const size_t length = NUM_COPIES * sim_.length;
+  struct capture_edge *edges = malloc(length * sizeof edges[0]);
+  if (edges == nullptr) {
+    return EXIT_FAILURE;
+  }
+  uint64_t time = 0U;
+  for (size_t i = 0U; i < length; ++i) {
+    edges[i] = (struct capture_edge){time, sim_.steps[i % sim_.length].input};
+    time += sim_.steps[i % sim_.length].duration;
+  }
+
+  struct timespec start;
+  timespec_get(&start, TIME_UTC);
+  struct offline_readings expected = {nullptr, 0U, 0U};
+  bool ok = offline_decode_sequential(edges, length, &expected);
+  const double sequential = seconds_since(&start);
+  printf("sequential: %zu readings of %.1f h in %.3f s, %.1f Medges/s\n",
+         expected.count, (double)time * 1e-6 / 3600.0, sequential,
+         (double)length / sequential * 1e-6);
+
+  const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  const size_t max_threads = cores > 4 ? (size_t)cores : 4U;
+  for (size_t threads = 1U; ok && threads <= max_threads; threads *= 2U) {
+    struct offline_readings actual = {nullptr, 0U, 0U};
+    timespec_get(&start, TIME_UTC);
+    ok = offline_decode(edges, length, threads, &actual);
+    const double elapsed = seconds_since(&start);
+    printf("%2zu threads: %.3f s, %.1f Medges/s, %.2fx\n", threads, elapsed,
+           (double)length / elapsed * 1e-6, sequential / elapsed);
+    ok = ok && same(&expected, &actual);
+    free(actual.readings);
+  }
+  free(expected.readings);
+  free(edges);
+  if (!ok) {
+    printf("readings differ\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+// Profiles the firmware on the simulated MCU, see `msp430/mcu_sim.c`, by the
+// hooks that GCC calls on entry and exit of each function, if compiled with
+// `-finstrument-functions`.
+//
+// The time between two hooks is counted for the innermost function on the call
+// stack that has been named by `profile_function()`, and for the path of named
+// functions that leads to it. The other functions are counted as part of their
+// caller. Functions named `nullptr` are not counted at all, only the functions
+// they call, e.g. the ISRs that are called while the simulation sleeps.
+//
+// The time is counted in cycles of the host, as there is no model of the
+// MSP430's cycles. So the profile tells where the firmware spends its time
+// relative to other parts, not how long it takes on the MCU.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define PROFILE_MAX_FUNCTIONS 64U
+#define PROFILE_MAX_NODES     512U
+#define PROFILE_MAX_DEPTH     256U
+
+#define PROFILE_HOOK __attribute__((no_instrument_function))
+
+struct profile_function {
+  uintptr_t address;
+  const char *name;
+  uint64_t calls;
+};
+
+// A path of named functions from the root, in a tree.
+struct profile_node {
+  u16 parent;
+  u16 function;
+  uint64_t cycles; // with this node on top
+};
+
+static struct {
+  struct profile_function functions[PROFILE_MAX_FUNCTIONS];
+  size_t num_functions;
+  struct profile_node nodes[PROFILE_MAX_NODES]; // 0 is the root
+  size_t num_nodes;
+  u16 stack[PROFILE_MAX_DEPTH]; // the node of each call
+  size_t depth;
+  uint64_t last; // cycles at the end of the last hook
+} profile_ = {.num_nodes = 1U};
+
+PROFILE_HOOK static uint64_t profile_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// Names the function at the given address, or hides it, if `name` is null.
+PROFILE_HOOK static void profile_function(const uintptr_t address,
+                                          const char *name) {
+  if (profile_.num_functions < PROFILE_MAX_FUNCTIONS) {
+    profile_.functions[profile_.num_functions++] =
+        (struct profile_function){address, name, 0U};
+  }
+}
+
+PROFILE_HOOK static u16 profile_top(void) {
+  return profile_.depth > 0U
+             ? profile_.stack[profile_.depth < PROFILE_MAX_DEPTH
+                                  ? profile_.depth - 1U
+                                  : PROFILE_MAX_DEPTH - 1U]
+             : 0U;
+}
+
+// Counts the cycles since the last hook.
+PROFILE_HOOK static void profile_count(const uint64_t now) {
+  profile_.nodes[profile_top()].cycles += now - profile_.last;
+}
+
+// Returns the node of the function as called with the given node on top.
+PROFILE_HOOK static u16 profile_node(const u16 parent, const u16 function) {
+  for (size_t i = 1U; i < profile_.num_nodes; ++i) {
+    if (profile_.nodes[i].parent == parent &&
+        profile_.nodes[i].function == function) {
+      return (u16)i;
+    }
+  }
+  if (profile_.num_nodes == PROFILE_MAX_NODES) {
+    return parent;
+  }
+  profile_.nodes[profile_.num_nodes] =
+      (struct profile_node){parent, function, 0U};
+  return (u16)profile_.num_nodes++;
+}
+
+PROFILE_HOOK void __cyg_profile_func_enter(void *fn, void *site) {
+  (void)site;
+  const uint64_t now = profile_clock();
+  profile_count(now);
+  u16 node = profile_top();
+  for (size_t i = 0U; i < profile_.num_functions; ++i) {
+    if (profile_.functions[i].address == (uintptr_t)fn) {
+      profile_.functions[i].calls += 1U;
+      node = profile_node(node, (u16)i);
+      break;
+    }
+  }
+  if (profile_.depth < PROFILE_MAX_DEPTH) {
+    profile_.stack[profile_.depth] = node;
+  }
+  profile_.depth += 1U;
+  profile_.last = profile_clock();
+}
+
+PROFILE_HOOK void __cyg_profile_func_exit(void *fn, void *site) {
+  (void)fn;
+  (void)site;
+  profile_count(profile_clock());
+  profile_.depth -= profile_.depth > 0U ? 1U : 0U;
+  profile_.last = profile_clock();
+}
+
+// Returns the depth of the call stack, see `profile_unwind()`.
+PROFILE_HOOK static size_t profile_depth(void) { return profile_.depth; }
+
+// Drops the calls above the given depth, which have been left by `longjmp()`.
+PROFILE_HOOK static void profile_unwind(const size_t depth) {
+  profile_count(profile_clock());
+  profile_.depth = depth;
+  profile_.last = profile_clock();
+}
+
+PROFILE_HOOK static bool profile_hidden(const u16 node) {
+  return node != 0U &&
+         profile_.functions[profile_.nodes[node].function].name == nullptr;
+}
+
+PROFILE_HOOK static void profile_print_path(FILE *out, u16 node) {
+  const char *names[PROFILE_MAX_DEPTH];
+  size_t depth = 0U;
+  for (; node != 0U && depth < PROFILE_MAX_DEPTH;
+       node = profile_.nodes[node].parent) {
+    if (!profile_hidden(node)) {
+      names[depth++] = profile_.functions[profile_.nodes[node].function].name;
+    }
+  }
+  while (depth > 0U) {
+    depth -= 1U;
+    fprintf(out, "%s%c", names[depth], depth > 0U ? ';' : ' ');
+  }
+}
+
+// Writes the profile as folded stacks, i.e. one line per path of functions
+// with its cycles, e.g. `main;send_serial;on_usi 1234`, as read by
+// `flamegraph.pl` and speedscope.
+PROFILE_HOOK static void profile_write_folded(FILE *out) {
+  for (u16 i = 1U; i < profile_.num_nodes; ++i) {
+    if (profile_.nodes[i].cycles > 0U && !profile_hidden(i)) {
+      profile_print_path(out, i);
+      fprintf(out, "%llu\n", (unsigned long long)profile_.nodes[i].cycles);
+    }
+  }
+}
+
+// Returns the cycles of the function, in total or on top of the call stack.
+PROFILE_HOOK static uint64_t profile_cycles(const size_t function,
+                                            const bool total) {
+  uint64_t cycles = 0U;
+  for (u16 i = 1U; i < profile_.num_nodes; ++i) {
+    if (profile_hidden(i)) {
+      continue;
+    }
+    for (u16 n = i; n != 0U; n = total ? profile_.nodes[n].parent : 0U) {
+      if (profile_.nodes[n].function == function) {
+        cycles += profile_.nodes[i].cycles;
+        break;
+      }
+    }
+  }
+  return cycles;
+}
+
+// Prints the calls and cycles of each named function per reading.
+PROFILE_HOOK static void profile_print(FILE *out, const size_t readings) {
+  fprintf(out, "%-20s %10s %12s %12s\n", "per reading", "calls",
+          "self cycles", "total cycles");
+  for (size_t i = 0U; i < profile_.num_functions; ++i) {
+    const struct profile_function *f = &profile_.functions[i];
+    if (f->name != nullptr) {
+      fprintf(out, "%-20s %10.1f %12.0f %12.0f\n", f->name,
+              (double)f->calls / (double)readings,
+              (double)profile_cycles(i, false) / (double)readings,
+              (double)profile_cycles(i, true) / (double)readings);
+    }
+  }
+}
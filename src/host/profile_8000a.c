@@ -0,0 +1,104 @@
+// Profiles the 8000A firmware on the simulated MCU, see `msp430/mcu_sim.c`,
+// while it decodes and sends the readings of the simulated bus: the cycles of
+// each function, see `profile.c`, the wakeups, and the time in LPM.
+//
+// The profile is also written as folded stacks to the file given as argument,
+// for flame graphs, e.g. `flamegraph.pl build/profile_8000a.folded`.
+
+#define MSP430_SIM
+
+#include "../8000a_firmware.c"
+#include "../8000a_sim.c"
+#include "profile.c"
+
+#undef main
+
+#include <stdlib.h>
+
+#define NUM_PERIODS 60
+
+static struct sim sim_;
+static struct mcu_edge edges_[SIM_MAX_TICKS + 1U];
+
+#define PROFILED(f) {(uintptr_t)f, #f}
+#define HIDDEN(f)   {(uintptr_t)f, nullptr}
+
+static const struct {
+  uintptr_t address;
+  const char *name;
+} functions_[] = {
+    {(uintptr_t)firmware_main, "main"},
+    PROFILED(capture_input),
+    PROFILED(remap_ports),
+    PROFILED(filter_strobe),
+    PROFILED(decode),
+    PROFILED(decode_next),
+    PROFILED(telemetry_decoded),
+    PROFILED(telemetry_period),
+    PROFILED(aclk_now),
+    PROFILED(print_output),
+    PROFILED(print_reading),
+    PROFILED(bcd2digit),
+    PROFILED(send_serial),
+    PROFILED(start_sending),
+    PROFILED(send_next_char),
+    PROFILED(send_char),
+    PROFILED(frame_check_update),
+    PROFILED(retained_commit),
+    PROFILED(on_port1),
+    PROFILED(on_usi),
+    // the simulation, but not the ISRs that it calls
+    HIDDEN(mcu_sleep),
+    HIDDEN(mcu_enable_interrupts),
+    HIDDEN(mcu_disable_interrupts),
+};
+
+int main(const int argc, const char *argv[]) {
+  // a different reading in each period
+  srand(46);
+  for (int i = 0; i < NUM_PERIODS; ++i) {
+    const unsigned digits[4] = {0x6U, (unsigned)rand() % 10U,
+                                (unsigned)rand() % 10U, (unsigned)rand() % 10U};
+    sim_period(&sim_, digits);
+  }
+  size_t length = sim_edges(&sim_, edges_);
+  // time to send the last reading
+  edges_[length] = edges_[length - 1U];
+  edges_[length++].time += 100000U;
+
+  for (size_t i = 0U; i < sizeof functions_ / sizeof functions_[0]; ++i) {
+    profile_function(functions_[i].address, functions_[i].name);
+  }
+  const struct mcu_board board = {&vt, Tx, SERIAL_BAUD_RATE, 0U, 0U};
+  const size_t depth = profile_depth();
+  const enum mcu_exit exit = mcu_run(&board, edges_, length);
+  profile_unwind(depth);
+
+  size_t readings = 0U;
+  for (size_t i = 0U; i < mcu_.output_length; ++i) {
+    readings += mcu_.output[i] == '\n' ? 1U : 0U;
+  }
+  if (exit != MCU_END || readings == 0U) {
+    printf("simulation failed after %zu readings\n", readings);
+    return EXIT_FAILURE;
+  }
+
+  const double n = (double)readings;
+  printf("8000A, %zu readings, %.1f s\n", readings,
+         (double)mcu_.now / MCU_TICKS_PER_US * 1e-6);
+  printf("per reading: %.1f interrupts, %.1f wakeups, %.1f ms in LPM\n",
+         mcu_.interrupts / n, mcu_.wakeups / n,
+         (double)mcu_.sleep_ticks / MCU_TICKS_PER_US * 1e-3 / n);
+  profile_print(stdout, readings);
+
+  if (argc > 1) {
+    FILE *out = fopen(argv[1], "w");
+    if (out == nullptr) {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+    }
+    profile_write_folded(out);
+    fclose(out);
+  }
+  return EXIT_SUCCESS;
+}
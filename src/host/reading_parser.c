@@ -0,0 +1,378 @@
+// Batch parser for the ASCII readings printed by the DOUs, see
+// `print_reading()` in `8000a.c` and `1900a.c`.
+//
+// Both line layouts are described once by the character classes below. The
+// scalar parser walks them directly, while the SSE2 parser derives its
+// comparison vectors from the same tables, so both give identical results.
+// Lines that do not match the layout are not dropped, but flagged invalid, so
+// that the row index still corresponds to the line index of the stream.
+
+#include "../1900a.c"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+enum meter { METER_8000A, METER_1900A };
+
+enum char_class {
+  CLASS_DIGIT,    // '0'..'9'
+  CLASS_OVERLOAD, // ' ' or '>'
+  CLASS_SIGN,     // '-' or '+'
+  CLASS_HALF,     // ' ' or '1', the ½ digit of the 8000A
+  CLASS_CR,
+  CLASS_LF,
+};
+
+// The two characters accepted for a class. The index of the matching
+// character is the value of the class, e.g. 1 for '>' or '+'.
+static const char class_chars_[][2] = {
+    [CLASS_DIGIT] = {'\0', '\0'}, [CLASS_OVERLOAD] = {' ', '>'},
+    [CLASS_SIGN] = {'-', '+'},    [CLASS_HALF] = {' ', '1'},
+    [CLASS_CR] = {'\r', '\r'},    [CLASS_LF] = {'\n', '\n'}};
+
+// `<overload><polarity><MSD><2SD><3SD><LSD>\r\n`
+static const enum char_class format_8000a_[] = {
+    CLASS_OVERLOAD, CLASS_SIGN,  CLASS_HALF, CLASS_DIGIT,
+    CLASS_DIGIT,    CLASS_DIGIT, CLASS_CR,   CLASS_LF};
+#define LINE_SIZE_8000A (sizeof format_8000a_ / sizeof format_8000a_[0])
+
+// `<overflow><6 digits with optional decimal point><unit>\r\n`
+#define LINE_SIZE_MIN_1900A (1U + NUMBER_OF_DIGITS + 2U)
+#define LINE_SIZE_MAX_1900A (MAX_READING_SIZE - 1U)
+
+#define READING_OVERLOAD (0x01U)
+#define READING_INVALID  (0x02U)
+#define READING_HELD     (0x04U) // 8000A overload repeated in a blank period
+
+// Replaces the overload indicator for held readings, see `8000a.c`.
+#define HELD_INDICATOR_8000A '='
+
+// One row per parsed line. The displayed number is `value * 10^exponent`
+// in `unit`; `NoUnit` for the 8000A and for 1900A readings without unit.
+struct reading_columns {
+  int32_t *value;
+  int8_t *exponent;
+  u8 *flags; // READING_OVERLOAD, READING_INVALID, READING_HELD
+  u8 *unit;  // `enum unit`
+};
+
+static bool is_digit(const char c) { return c >= '0' && c <= '9'; }
+
+static int match_class(const enum char_class cls, const char c) {
+  if (cls == CLASS_DIGIT) {
+    return is_digit(c) ? c - '0' : -1;
+  }
+  return c == class_chars_[cls][1] ? 1 : c == class_chars_[cls][0] ? 0 : -1;
+}
+
+static void set_invalid(const struct reading_columns out, const size_t row) {
+  out.value[row] = 0;
+  out.exponent[row] = 0;
+  out.flags[row] = READING_INVALID;
+  out.unit[row] = NoUnit;
+}
+
+static void parse_line_8000a(const char *line, const size_t size,
+                             const struct reading_columns out,
+                             const size_t row) {
+  if (size != LINE_SIZE_8000A) {
+    set_invalid(out, row);
+    return;
+  }
+  // Held readings are rare enough to leave them to this parser.
+  const bool held = line[0] == HELD_INDICATOR_8000A;
+  int values[LINE_SIZE_8000A];
+  for (size_t i = 0U; i < LINE_SIZE_8000A; ++i) {
+    values[i] = held && i == 0U ? 1 : match_class(format_8000a_[i], line[i]);
+    if (values[i] < 0) {
+      set_invalid(out, row);
+      return;
+    }
+  }
+  const int magnitude =
+      values[2] * 1000 + values[3] * 100 + values[4] * 10 + values[5];
+  out.value[row] = values[1] ? magnitude : -magnitude;
+  out.exponent[row] = 0;
+  out.flags[row] = (u8)((values[0] ? READING_OVERLOAD : 0U) |
+                        (held ? READING_HELD : 0U));
+  out.unit[row] = NoUnit;
+}
+
+static int find_unit(const char *text, const size_t size) {
+  if (size >= MAX_UNIT_LENGTH) {
+    return -1;
+  }
+  // The texts contain no inner terminators, so this is `strlen() == size`.
+  for (int u = ms; u <= NoUnit; ++u) {
+    if (unit_texts_[u][size] == '\0' &&
+        (size == 0U || unit_texts_[u][size - 1U] != '\0') &&
+        memcmp(unit_texts_[u], text, size) == 0) {
+      return u;
+    }
+  }
+  return -1;
+}
+
+static void parse_line_1900a(const char *line, const size_t size,
+                             const struct reading_columns out,
+                             const size_t row) {
+  if (size < LINE_SIZE_MIN_1900A || size > LINE_SIZE_MAX_1900A ||
+      match_class(CLASS_CR, line[size - 2U]) < 0) {
+    set_invalid(out, row);
+    return;
+  }
+  const int overflow = match_class(CLASS_OVERLOAD, line[0]);
+  if (overflow < 0) {
+    set_invalid(out, row);
+    return;
+  }
+  int32_t value = 0;
+  int digits = 0;
+  int point = -1; // number of digits before the decimal point
+  size_t i = 1U;
+  for (; i < size - 2U && (digits < NUMBER_OF_DIGITS || line[i] == '.'); ++i) {
+    if (is_digit(line[i])) {
+      value = value * 10 + (line[i] - '0');
+      ++digits;
+    } else if (line[i] == '.' && point < 0) {
+      point = digits;
+    } else {
+      break;
+    }
+  }
+  const int unit = find_unit(&line[i], size - 2U - i);
+  if (digits != NUMBER_OF_DIGITS || unit < 0) {
+    set_invalid(out, row);
+    return;
+  }
+  out.value[row] = value;
+  out.exponent[row] = (int8_t)(point < 0 ? 0 : point - NUMBER_OF_DIGITS);
+  out.flags[row] = overflow ? READING_OVERLOAD : 0U;
+  out.unit[row] = (u8)unit;
+}
+
+static struct reading_columns out_offset(const struct reading_columns out,
+                                         const size_t row) {
+  return (struct reading_columns){&out.value[row], &out.exponent[row],
+                                  &out.flags[row], &out.unit[row]};
+}
+
+static void parse_line(const enum meter meter, const char *line,
+                       const size_t size, const struct reading_columns out,
+                       const size_t row) {
+  if (meter == METER_8000A) {
+    parse_line_8000a(line, size, out, row);
+  } else {
+    parse_line_1900a(line, size, out, row);
+  }
+}
+
+// Parses up to `capacity` complete lines from `text` into the rows of `out`.
+// Returns the number of rows written and stores the number of bytes consumed
+// to `consumed`. A trailing partial line is left for the next call.
+static size_t parse_readings_scalar(const enum meter meter, const char *text,
+                                    const size_t size,
+                                    const struct reading_columns out,
+                                    const size_t capacity, size_t *consumed) {
+  size_t row = 0U;
+  size_t pos = 0U;
+  while (row < capacity) {
+    const char *end = memchr(&text[pos], '\n', size - pos);
+    if (end == nullptr) {
+      break;
+    }
+    const size_t line_size = (size_t)(end - &text[pos]) + 1U;
+    parse_line(meter, &text[pos], line_size, out, row++);
+    pos += line_size;
+  }
+  *consumed = pos;
+  return row;
+}
+
+#if defined(__SSE2__)
+
+// Per-byte comparison vectors for two 8000A lines in one 16 byte register.
+struct class_vectors_8000a {
+  __m128i first;   // the character with class value 0
+  __m128i second;  // the character with class value 1
+  __m128i digit;   // 0xff, where `CLASS_DIGIT` is expected
+  __m128i weights; // 16 bit decimal weights of the digits of one line
+};
+
+static struct class_vectors_8000a make_class_vectors_8000a(void) {
+  char first[16];
+  char second[16];
+  char digit[16];
+  for (size_t i = 0U; i < 16U; ++i) {
+    const enum char_class cls = format_8000a_[i % LINE_SIZE_8000A];
+    first[i] = class_chars_[cls][0];
+    second[i] = class_chars_[cls][1];
+    digit[i] = cls == CLASS_DIGIT ? (char)0xff : 0;
+  }
+  return (struct class_vectors_8000a){
+      _mm_loadu_si128((const __m128i *)first),
+      _mm_loadu_si128((const __m128i *)second),
+      _mm_loadu_si128((const __m128i *)digit),
+      _mm_setr_epi16(0, 0, 1000, 100, 10, 1, 0, 0)};
+}
+
+// Returns a mask of the bytes in '0'..'9'.
+static __m128i classify_digits(const __m128i chars) {
+  const __m128i offset = _mm_sub_epi8(chars, _mm_set1_epi8('0' - 128));
+  return _mm_cmplt_epi8(offset, _mm_set1_epi8(-128 + 10));
+}
+
+static int32_t sum_epi32(const __m128i v) {
+  const __m128i pairs = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4e));
+  return _mm_cvtsi128_si32(
+      _mm_add_epi32(pairs, _mm_shuffle_epi32(pairs, 0xb1)));
+}
+
+// Parses two adjacent 8000A lines. Returns false if either line is malformed,
+// in which case nothing is written and the scalar parser takes over.
+static bool parse_pair_8000a(const struct class_vectors_8000a *cv,
+                             const char *text, const struct reading_columns out,
+                             const size_t row) {
+  const __m128i chars = _mm_loadu_si128((const __m128i *)text);
+  const __m128i digits = classify_digits(chars);
+  const __m128i is_first = _mm_cmpeq_epi8(chars, cv->first);
+  const __m128i is_second = _mm_cmpeq_epi8(chars, cv->second);
+  const __m128i either = _mm_or_si128(is_first, is_second);
+  const __m128i valid = _mm_or_si128(_mm_and_si128(digits, cv->digit),
+                                     _mm_andnot_si128(cv->digit, either));
+  if (_mm_movemask_epi8(valid) != 0xffff) {
+    return false;
+  }
+
+  // The ½ digit is a class value, the others are digits.
+  const __m128i values = _mm_or_si128(
+      _mm_and_si128(_mm_sub_epi8(chars, _mm_set1_epi8('0')), cv->digit),
+      _mm_andnot_si128(cv->digit, _mm_and_si128(is_second, _mm_set1_epi8(1))));
+  const __m128i zero = _mm_setzero_si128();
+  const int32_t magnitudes[2] = {
+      sum_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(values, zero), cv->weights)),
+      sum_epi32(_mm_madd_epi16(_mm_unpackhi_epi8(values, zero), cv->weights))};
+
+  const unsigned seconds = (unsigned)_mm_movemask_epi8(is_second);
+  for (size_t i = 0U; i < 2U; ++i) {
+    const unsigned line = seconds >> (i * LINE_SIZE_8000A);
+    out.value[row + i] = (line & 0x2U) ? magnitudes[i] : -magnitudes[i];
+    out.exponent[row + i] = 0;
+    out.flags[row + i] = (line & 0x1U) ? READING_OVERLOAD : 0U;
+    out.unit[row + i] = NoUnit;
+  }
+  return true;
+}
+
+// Parses the 1900A line starting at `text`, if it fits into 16 bytes.
+// Returns the size of the line or 0, if the scalar parser has to take over.
+static size_t parse_line_1900a_sse2(const char *text,
+                                    const struct reading_columns out,
+                                    const size_t row) {
+  const __m128i chars = _mm_loadu_si128((const __m128i *)text);
+  const unsigned newlines =
+      (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\n')));
+  if (newlines == 0U) {
+    return 0U;
+  }
+  const size_t size = (size_t)__builtin_ctz(newlines) + 1U;
+  const unsigned in_line = (1U << size) - 1U;
+  const unsigned digits = (unsigned)_mm_movemask_epi8(classify_digits(chars));
+  const unsigned points =
+      (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('.'))) &
+      in_line;
+  const unsigned overflow =
+      (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('>')));
+  const unsigned blank =
+      (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')));
+
+  // The field of digits starts at index 1 and contains at most one point.
+  const int num_points = __builtin_popcount(points);
+  const unsigned field = ((1U << (NUMBER_OF_DIGITS + num_points)) - 1U) << 1U;
+  if (size < LINE_SIZE_MIN_1900A || size > LINE_SIZE_MAX_1900A ||
+      text[size - 2U] != '\r' || ((overflow | blank) & 1U) == 0U ||
+      num_points > 1 || (points & ~field) != 0U ||
+      ((digits | points) & field) != field) {
+    parse_line_1900a(text, size, out, row);
+    return size;
+  }
+  const size_t unit_begin = 1U + NUMBER_OF_DIGITS + (size_t)num_points;
+  const int unit = find_unit(&text[unit_begin], size - 2U - unit_begin);
+  if (unit < 0) {
+    set_invalid(out, row);
+    return size;
+  }
+
+  char values[16];
+  _mm_storeu_si128((__m128i *)values, _mm_sub_epi8(chars, _mm_set1_epi8('0')));
+  int32_t value = 0;
+  for (unsigned bits = digits & field; bits != 0U; bits &= bits - 1U) {
+    value = value * 10 + values[__builtin_ctz(bits)];
+  }
+  out.value[row] = value;
+  out.exponent[row] =
+      (int8_t)(num_points == 0
+                   ? 0
+                   : __builtin_ctz(points) - 1 - NUMBER_OF_DIGITS);
+  out.flags[row] = (overflow & 1U) ? READING_OVERLOAD : 0U;
+  out.unit[row] = (u8)unit;
+  return size;
+}
+
+// Same as `parse_readings_scalar()`, but classifies 16 bytes at once.
+static size_t parse_readings(const enum meter meter, const char *text,
+                             const size_t size,
+                             const struct reading_columns out,
+                             const size_t capacity, size_t *consumed) {
+  const struct class_vectors_8000a cv = make_class_vectors_8000a();
+  size_t row = 0U;
+  size_t pos = 0U;
+  while (size - pos >= 16U && row < capacity) {
+    if (meter == METER_8000A) {
+      if (row + 2U <= capacity && parse_pair_8000a(&cv, &text[pos], out, row)) {
+        row += 2U;
+        pos += 2U * LINE_SIZE_8000A;
+        continue;
+      }
+    } else {
+      const size_t line_size = parse_line_1900a_sse2(&text[pos], out, row);
+      if (line_size != 0U) {
+        row += 1U;
+        pos += line_size;
+        continue;
+      }
+    }
+    // malformed or overlong line
+    size_t line_consumed = 0U;
+    const size_t rows = parse_readings_scalar(meter, &text[pos], size - pos,
+                                              out_offset(out, row), 1U,
+                                              &line_consumed);
+    row += rows;
+    pos += line_consumed;
+    if (rows == 0U) {
+      break;
+    }
+  }
+  size_t tail_consumed = 0U;
+  row += parse_readings_scalar(meter, &text[pos], size - pos,
+                               out_offset(out, row), capacity - row,
+                               &tail_consumed);
+  *consumed = pos + tail_consumed;
+  return row;
+}
+
+#else
+
+static size_t parse_readings(const enum meter meter, const char *text,
+                             const size_t size,
+                             const struct reading_columns out,
+                             const size_t capacity, size_t *consumed) {
+  return parse_readings_scalar(meter, text, size, out, capacity, consumed);
+}
+
+#endif
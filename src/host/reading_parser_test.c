@@ -0,0 +1,159 @@
+// Tests the batch parser against known lines and the scalar reference.
+
+#include "reading_parser.c"
+
+#include <unity.h>
+
+#include <stdlib.h>
+
+#define MAX_ROWS 4096U
+
+static int32_t values_[2][MAX_ROWS];
+static int8_t exponents_[2][MAX_ROWS];
+static u8 flags_[2][MAX_ROWS];
+static u8 units_[2][MAX_ROWS];
+
+static struct reading_columns columns(const int idx) {
+  return (struct reading_columns){values_[idx], exponents_[idx], flags_[idx],
+                                  units_[idx]};
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_parse_8000a(void) {
+  static const char text[] = " -0000\r\n"
+                             " +1999\r\n"
+                             ">+1000\r\n"
+                             " + 042\r\n"
+                             " +x042\r\n"
+                             " - 123\r\n"
+                             "=+1000\r\n"
+                             " -0";
+  size_t consumed = 0U;
+  const size_t rows = parse_readings(METER_8000A, text, sizeof text - 1U,
+                                     columns(0), MAX_ROWS, &consumed);
+  TEST_ASSERT_EQUAL_size_t(7U, rows);
+  TEST_ASSERT_EQUAL_size_t(sizeof text - 4U, consumed);
+
+  TEST_ASSERT_EQUAL_INT32(0, values_[0][0]);
+  TEST_ASSERT_EQUAL_INT32(1999, values_[0][1]);
+  TEST_ASSERT_EQUAL_INT32(1000, values_[0][2]);
+  TEST_ASSERT_EQUAL_UINT8(READING_OVERLOAD, flags_[0][2]);
+  TEST_ASSERT_EQUAL_INT32(42, values_[0][3]);
+  TEST_ASSERT_EQUAL_UINT8(0U, flags_[0][3]);
+  TEST_ASSERT_EQUAL_UINT8(READING_INVALID, flags_[0][4]);
+  TEST_ASSERT_EQUAL_INT32(-123, values_[0][5]);
+  TEST_ASSERT_EQUAL_UINT8(NoUnit, units_[0][5]);
+  TEST_ASSERT_EQUAL_INT32(1000, values_[0][6]);
+  TEST_ASSERT_EQUAL_UINT8(READING_OVERLOAD | READING_HELD, flags_[0][6]);
+}
+
+void test_parse_1900a(void) {
+  static const char text[] = " 001.234MHz\r\n"
+                             ">999999\r\n"
+                             " 12345.6ms\r\n"
+                             " 1234.56Hz\r\n"
+                             " .000001us\r\n"
+                             " 100000.kHz\r\n"
+                             " 1.2.3456kHz\r\n";
+  size_t consumed = 0U;
+  const size_t rows = parse_readings(METER_1900A, text, sizeof text - 1U,
+                                     columns(0), MAX_ROWS, &consumed);
+  TEST_ASSERT_EQUAL_size_t(7U, rows);
+  TEST_ASSERT_EQUAL_size_t(sizeof text - 1U, consumed);
+
+  TEST_ASSERT_EQUAL_INT32(1234, values_[0][0]);
+  TEST_ASSERT_EQUAL_INT8(-3, exponents_[0][0]);
+  TEST_ASSERT_EQUAL_UINT8(MHz, units_[0][0]);
+  TEST_ASSERT_EQUAL_INT32(999999, values_[0][1]);
+  TEST_ASSERT_EQUAL_INT8(0, exponents_[0][1]);
+  TEST_ASSERT_EQUAL_UINT8(READING_OVERLOAD, flags_[0][1]);
+  TEST_ASSERT_EQUAL_UINT8(NoUnit, units_[0][1]);
+  TEST_ASSERT_EQUAL_INT32(123456, values_[0][2]);
+  TEST_ASSERT_EQUAL_INT8(-1, exponents_[0][2]);
+  TEST_ASSERT_EQUAL_UINT8(ms, units_[0][2]);
+  TEST_ASSERT_EQUAL_UINT8(READING_INVALID, flags_[0][3]);
+  TEST_ASSERT_EQUAL_INT32(1, values_[0][4]);
+  TEST_ASSERT_EQUAL_INT8(-6, exponents_[0][4]);
+  TEST_ASSERT_EQUAL_UINT8(us, units_[0][4]);
+  TEST_ASSERT_EQUAL_INT32(100000, values_[0][5]);
+  TEST_ASSERT_EQUAL_INT8(0, exponents_[0][5]);
+  TEST_ASSERT_EQUAL_UINT8(kHz, units_[0][5]);
+  TEST_ASSERT_EQUAL_UINT8(READING_INVALID, flags_[0][6]);
+}
+
+static size_t random_line(const enum meter meter, char *line) {
+  static const char noise[] = " >+-.0123456789MHzkmsu\r\n";
+  size_t size = 0U;
+  if (meter == METER_8000A) {
+    line[size++] = " >>="[rand() % 8 ? 0 : 1 + rand() % 3];
+    line[size++] = rand() % 2 ? '+' : '-';
+    line[size++] = rand() % 2 ? '1' : ' ';
+    for (int i = 0; i < 3; ++i) {
+      line[size++] = (char)('0' + rand() % 10);
+    }
+  } else {
+    line[size++] = rand() % 8 ? ' ' : '>';
+    const int point = rand() % (NUMBER_OF_DIGITS + 2);
+    for (int i = 0; i < NUMBER_OF_DIGITS; ++i) {
+      if (i == point) {
+        line[size++] = '.';
+      }
+      line[size++] = (char)('0' + rand() % 10);
+    }
+    const char *unit = unit_texts_[rand() % (NoUnit + 1)];
+    size = (size_t)(print_str(&line[size], &line[MAX_READING_SIZE], unit) -
+                    line);
+  }
+  line[size++] = '\r';
+  line[size++] = '\n';
+  // corrupt every tenth line
+  if (rand() % 10 == 0) {
+    line[(size_t)rand() % size] = noise[(size_t)rand() % (sizeof noise - 1U)];
+  }
+  return size;
+}
+
+static void check_equivalence(const enum meter meter) {
+  static char text[MAX_ROWS * MAX_READING_SIZE];
+  size_t size = 0U;
+  for (size_t i = 0U; i < MAX_ROWS - 1U; ++i) {
+    size += random_line(meter, &text[size]);
+  }
+
+  size_t consumed[2];
+  const size_t rows[2] = {
+      parse_readings_scalar(meter, text, size, columns(0), MAX_ROWS,
+                            &consumed[0]),
+      parse_readings(meter, text, size, columns(1), MAX_ROWS, &consumed[1])};
+  TEST_ASSERT_EQUAL_size_t(rows[0], rows[1]);
+  TEST_ASSERT_EQUAL_size_t(consumed[0], consumed[1]);
+  TEST_ASSERT_EQUAL_INT32_ARRAY(values_[0], values_[1], rows[0]);
+  TEST_ASSERT_EQUAL_INT8_ARRAY(exponents_[0], exponents_[1], rows[0]);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(flags_[0], flags_[1], rows[0]);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(units_[0], units_[1], rows[0]);
+}
+
+void test_8000a_equals_reference(void) {
+  srand(8000);
+  for (int i = 0; i < 16; ++i) {
+    check_equivalence(METER_8000A);
+  }
+}
+
+void test_1900a_equals_reference(void) {
+  srand(1900);
+  for (int i = 0; i < 16; ++i) {
+    check_equivalence(METER_1900A);
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_8000a);
+  RUN_TEST(test_parse_1900a);
+  RUN_TEST(test_8000a_equals_reference);
+  RUN_TEST(test_1900a_equals_reference);
+  return UNITY_END();
+}
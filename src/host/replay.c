@@ -0,0 +1,286 @@
+// Replays recorded DOU output into pseudo-terminals, so that host software can
+// be tested against many simulated meters, e.g.
+//
+//     replay -n 1000 -s 10 recording.txt
+//
+// Each line of the recording is one reading as printed by `print_reading()`,
+// optionally preceded by its time in seconds and a tab, as produced by
+// `ts '%.s'` or the simulators. Lines without time follow each other at the
+// given interval. Bytes are paced like the serial output of the DOU
+// (`SERIAL_BAUD_RATE`, `SERIAL_DATA_BITS`), and all times are divided by the
+// speed factor. The names of the pseudo-terminals are printed to stdout, one
+// per line, before the replay starts. Instances are staggered evenly over one
+// interval, so that they don't all send at the same time.
+
+#define _XOPEN_SOURCE 700
+
+#include "../dou.c"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// start bit + data bits + stop bit
+#define SERIAL_CHAR_TIME ((SERIAL_DATA_BITS + 2.0) / SERIAL_BAUD_RATE)
+
+struct recording {
+  char *text;
+  size_t size;
+  struct reading {
+    double time; // s, relative to the first reading
+    size_t offset;
+    size_t size;
+  } *readings;
+  size_t count;
+  double duration; // until the reading after the last one would be due
+};
+
+struct stream {
+  int fd;
+  size_t reading;
+  size_t byte;
+  double epoch; // time of the first reading of the current pass
+  double next;  // time when the next byte is due
+  uint64_t written;
+  uint64_t dropped; // bytes nobody was reading, like a UART without listener
+};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void sleep_until(const double time) {
+  const struct timespec ts = {(time_t)time,
+                              (long)((time - (double)(time_t)time) * 1e9)};
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+         EINTR) {
+  }
+}
+
+static bool load_recording(struct recording *r, FILE *file,
+                           const double interval) {
+  size_t capacity = 0U;
+  r->size = 0U;
+  r->text = nullptr;
+  for (;;) {
+    if (r->size == capacity) {
+      capacity = capacity ? 2U * capacity : 65536U;
+      r->text = realloc(r->text, capacity);
+      if (r->text == nullptr) {
+        return false;
+      }
+    }
+    const size_t num_read =
+        fread(&r->text[r->size], 1U, capacity - r->size, file);
+    if (num_read == 0U) {
+      break;
+    }
+    r->size += num_read;
+  }
+
+  size_t num_lines = 0U;
+  for (size_t i = 0U; i < r->size; ++i) {
+    num_lines += r->text[i] == '\n' ? 1U : 0U;
+  }
+  r->readings = calloc(num_lines + 1U, sizeof r->readings[0]);
+  if (r->readings == nullptr) {
+    return false;
+  }
+  r->count = 0U;
+  double first = 0.0;
+  double time = 0.0;
+  for (size_t pos = 0U; pos < r->size;) {
+    const char *line = &r->text[pos];
+    const char *end = memchr(line, '\n', r->size - pos);
+    const size_t size = end ? (size_t)(end - line) + 1U : r->size - pos;
+    const char *tab = memchr(line, '\t', size);
+    struct reading *reading = &r->readings[r->count];
+    if (tab != nullptr) {
+      char *parsed = nullptr;
+      const double stamp = strtod(line, &parsed);
+      if (parsed == tab) {
+        first = r->count == 0U ? stamp : first;
+        time = stamp - first;
+      }
+      reading->offset = (size_t)(tab + 1 - r->text);
+    } else {
+      reading->offset = pos;
+    }
+    reading->time = time;
+    reading->size = size - (reading->offset - pos);
+    r->count += 1U;
+    time += interval;
+    pos += size;
+  }
+  r->duration = time;
+  return r->count > 0U;
+}
+
+static int open_pty(void) {
+  const int fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+    return -1;
+  }
+  // pass the bytes through as they are, like a USB-serial adapter would
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    tio.c_iflag = 0U;
+    tio.c_oflag = 0U;
+    tio.c_lflag = 0U;
+    tio.c_cflag = CS7 | CREAD | CLOCAL;
+    cfsetispeed(&tio, B19200);
+    cfsetospeed(&tio, B19200);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+// Min-heap of the streams, ordered by the time of their next byte.
+static void sift_down(struct stream **heap, const size_t count, size_t i) {
+  for (;;) {
+    size_t smallest = i;
+    const size_t left = 2U * i + 1U;
+    const size_t right = left + 1U;
+    if (left < count && heap[left]->next < heap[smallest]->next) {
+      smallest = left;
+    }
+    if (right < count && heap[right]->next < heap[smallest]->next) {
+      smallest = right;
+    }
+    if (smallest == i) {
+      return;
+    }
+    struct stream *tmp = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = tmp;
+    i = smallest;
+  }
+}
+
+// Sends the next byte of the stream and schedules the one after it. Returns
+// false, when the recording is through and the replay shall not loop.
+static bool send_next_byte(struct stream *s, const struct recording *r,
+                           const double speed, const bool loop) {
+  const struct reading *reading = &r->readings[s->reading];
+  const char c = r->text[reading->offset + s->byte];
+  if (write(s->fd, &c, 1U) == 1) {
+    s->written += 1U;
+  } else {
+    s->dropped += 1U;
+  }
+
+  const double after_byte = s->next + SERIAL_CHAR_TIME / speed;
+  if (++s->byte < reading->size) {
+    s->next = after_byte;
+    return true;
+  }
+  s->byte = 0U;
+  if (++s->reading == r->count) {
+    if (!loop) {
+      return false;
+    }
+    s->reading = 0U;
+    s->epoch += r->duration / speed;
+  }
+  // a reading never starts before the previous one is out
+  const double due = s->epoch + r->readings[s->reading].time / speed;
+  s->next = due > after_byte ? due : after_byte;
+  return true;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-n instances] [-s speed] [-i interval] [-l] "
+          "[recording]\n",
+          name);
+}
+
+int main(const int argc, char *argv[]) {
+  long instances = 1;
+  double speed = 1.0;
+  double interval = 0.1;
+  bool loop = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:i:l")) != -1) {
+    switch (opt) {
+    case 'n':
+      instances = strtol(optarg, nullptr, 10);
+      break;
+    case 's':
+      speed = strtod(optarg, nullptr);
+      break;
+    case 'i':
+      interval = strtod(optarg, nullptr);
+      break;
+    case 'l':
+      loop = true;
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (instances < 1 || speed <= 0.0 || interval <= 0.0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  FILE *file = optind < argc ? fopen(argv[optind], "rb") : stdin;
+  static struct recording recording;
+  if (file == nullptr || !load_recording(&recording, file, interval)) {
+    fprintf(stderr, "no recording\n");
+    return EXIT_FAILURE;
+  }
+
+  struct stream *streams = calloc((size_t)instances, sizeof streams[0]);
+  struct stream **heap = calloc((size_t)instances, sizeof heap[0]);
+  if (streams == nullptr || heap == nullptr) {
+    return EXIT_FAILURE;
+  }
+  const double start = now() + 1.0; // give the host some time to connect
+  for (size_t i = 0U; i < (size_t)instances; ++i) {
+    streams[i].fd = open_pty();
+    if (streams[i].fd < 0) {
+      perror("pty");
+      return EXIT_FAILURE;
+    }
+    streams[i].epoch =
+        start + interval / speed * (double)i / (double)instances;
+    streams[i].next = streams[i].epoch;
+    heap[i] = &streams[i];
+    printf("%s\n", ptsname(streams[i].fd));
+  }
+  fflush(stdout);
+
+  size_t active = (size_t)instances;
+  while (active > 0U) {
+    sleep_until(heap[0]->next);
+    const double t = now();
+    while (active > 0U && heap[0]->next <= t) {
+      if (!send_next_byte(heap[0], &recording, speed, loop)) {
+        heap[0] = heap[--active];
+      }
+      sift_down(heap, active, 0U);
+    }
+  }
+  // closing a pty discards what the host has not read yet
+  sleep_until(now() + 1.0);
+
+  uint64_t written = 0U;
+  uint64_t dropped = 0U;
+  for (size_t i = 0U; i < (size_t)instances; ++i) {
+    written += streams[i].written;
+    dropped += streams[i].dropped;
+  }
+  fprintf(stderr, "%llu bytes written, %llu dropped\n",
+          (unsigned long long)written, (unsigned long long)dropped);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+// Streaming frequency stability analysis of 1900A counter readings.
+//
+// The Allan deviation is computed for τ = 2^k τ0 with a cascade of block
+// means: stage n halves the rate of stage n-1 by averaging pairs, so it emits
+// non-overlapping means of 2^n samples. Level k ≥ 1 combines two adjacent
+// means of stage k-1 into a mean over τ and compares it to the mean over the
+// preceding τ. As the pair advances by one stage k-1 mean, i.e. by τ/2, the
+// estimates overlap by half, which needs only the last three means of each
+// stage. For k = 1 this is the fully overlapping estimator.
+// Besides that, a linear drift is fitted and a histogram is kept, all in
+// constant memory, regardless of the number of samples.
+
+#include "reading_parser.c"
+
+#include <math.h>
+
+#define STABILITY_LEVELS 24 // τ up to 2^23 τ0
+#define HISTOGRAM_BINS   64
+
+struct allan_level {
+  double previous[3]; // the latest means, oldest first
+  uint64_t seen;      // number of means received
+  double sum_squares; // of the differences
+  uint64_t terms;     // number of differences
+};
+
+struct stability {
+  double tau0; // s
+  struct allan_level levels[STABILITY_LEVELS];
+  struct {
+    double sum;
+    bool has_half;
+  } stages[STABILITY_LEVELS];
+
+  // least-squares line through (t, y), updated à la Welford
+  uint64_t count;
+  double mean_t;
+  double mean_y;
+  double m2_t;
+  double c_ty;
+  double min;
+  double max;
+
+  double histogram_min;
+  double histogram_width;
+  uint64_t below; // samples below `histogram_min`
+  uint64_t above; // samples at or above the last bin
+  uint64_t histogram[HISTOGRAM_BINS];
+};
+
+// Converts a parsed 1900A reading to SI units, i.e. Hz or s.
+static double parsed_to_si(const int32_t value, const int8_t exponent,
+                           const enum unit unit) {
+  return (double)value * pow(10.0, exponent + unit_si_[unit].exponent);
+}
+
+// Samples are expected every `tau0` seconds. The histogram covers
+// `[histogram_min, histogram_max)`. If that range is empty, e.g. for a span of
+// zero, all samples go into the first bin.
+static void stability_init(struct stability *s, const double tau0,
+                           const double histogram_min,
+                           const double histogram_max) {
+  *s = (struct stability){.tau0 = tau0,
+                          .min = INFINITY,
+                          .max = -INFINITY,
+                          .histogram_min = histogram_min,
+                          .histogram_width = (histogram_max - histogram_min) /
+                                             HISTOGRAM_BINS};
+}
+
+static void add_difference(struct allan_level *level, const double diff) {
+  level->sum_squares += diff * diff;
+  level->terms += 1U;
+}
+
+// Feeds a mean of 2^(k-1) samples to level k ≥ 1.
+static void add_half_block(struct allan_level *level, const double mean) {
+  if (level->seen >= 3U) {
+    add_difference(level, ((level->previous[2] + mean) -
+                           (level->previous[0] + level->previous[1])) /
+                              2.0);
+  }
+  level->previous[0] = level->previous[1];
+  level->previous[1] = level->previous[2];
+  level->previous[2] = mean;
+  level->seen += 1U;
+}
+
+static void add_to_histogram(struct stability *s, const double y) {
+  if (!(s->histogram_width > 0.0)) {
+    s->histogram[0] += 1U;
+    return;
+  }
+  const double bin = floor((y - s->histogram_min) / s->histogram_width);
+  if (bin < 0.0) {
+    s->below += 1U;
+  } else if (bin >= HISTOGRAM_BINS) {
+    s->above += 1U;
+  } else {
+    s->histogram[(size_t)bin] += 1U;
+  }
+}
+
+static void stability_add(struct stability *s, const double y) {
+  // level 0 compares adjacent samples
+  if (s->levels[0].seen > 0U) {
+    add_difference(&s->levels[0], y - s->levels[0].previous[2]);
+  }
+  s->levels[0].previous[2] = y;
+  s->levels[0].seen += 1U;
+
+  double mean = y;
+  for (size_t n = 0U; n + 1U < STABILITY_LEVELS; ++n) {
+    add_half_block(&s->levels[n + 1U], mean);
+    if (!s->stages[n].has_half) {
+      s->stages[n].sum = mean;
+      s->stages[n].has_half = true;
+      break;
+    }
+    mean = (s->stages[n].sum + mean) / 2.0;
+    s->stages[n].has_half = false;
+  }
+
+  const double t = (double)s->count * s->tau0;
+  s->count += 1U;
+  const double dt = t - s->mean_t;
+  s->mean_t += dt / (double)s->count;
+  s->mean_y += (y - s->mean_y) / (double)s->count;
+  s->m2_t += dt * (t - s->mean_t);
+  s->c_ty += dt * (y - s->mean_y);
+  s->min = fmin(s->min, y);
+  s->max = fmax(s->max, y);
+
+  add_to_histogram(s, y);
+}
+
+static double stability_tau(const struct stability *s, const size_t level) {
+  return ldexp(s->tau0, (int)level);
+}
+
+// Returns the Allan deviation at τ = 2^level τ0 or NaN, if there are not
+// enough samples for that τ yet.
+static double stability_adev(const struct stability *s, const size_t level) {
+  const struct allan_level *l = &s->levels[level];
+  if (l->terms == 0U) {
+    return NAN;
+  }
+  return sqrt(l->sum_squares / (2.0 * (double)l->terms));
+}
+
+// Returns the slope of the fitted line in units per second.
+static double stability_drift(const struct stability *s) {
+  return s->m2_t > 0.0 ? s->c_ty / s->m2_t : 0.0;
+}
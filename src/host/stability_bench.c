@@ -0,0 +1,100 @@
+// Benchmarks the stability analysis on synthetic white frequency noise, for
+// which the Allan deviation is σ/√m at τ = m τ0.
+
+#include "stability.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NUM_SAMPLES (1U << 22U)
+#define SIGMA       (1e-9)
+
+static uint64_t rng_state_ = 0x853c49e6748fea9bU;
+
+static double uniform(void) {
+  // xorshift64*
+  rng_state_ ^= rng_state_ >> 12U;
+  rng_state_ ^= rng_state_ << 25U;
+  rng_state_ ^= rng_state_ >> 27U;
+  return (double)((rng_state_ * 0x2545f4914f6cdd1dU) >> 11U) * 0x1p-53;
+}
+
+static double gaussian(void) {
+  // Box-Muller
+  static const double two_pi = 6.283185307179586;
+  return sqrt(-2.0 * log(1.0 - uniform())) * cos(two_pi * uniform());
+}
+
+static double seconds_since(const struct timespec *start) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  return (double)(now.tv_sec - start->tv_sec) +
+         (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static int bench_analysis(void) {
+  static double samples[NUM_SAMPLES];
+  for (size_t i = 0U; i < NUM_SAMPLES; ++i) {
+    samples[i] = SIGMA * gaussian();
+  }
+
+  static struct stability s;
+  stability_init(&s, 0.1, -5.0 * SIGMA, 5.0 * SIGMA);
+  struct timespec start;
+  timespec_get(&start, TIME_UTC);
+  for (size_t i = 0U; i < NUM_SAMPLES; ++i) {
+    stability_add(&s, samples[i]);
+  }
+  const double elapsed = seconds_since(&start);
+  printf("analysis: %u samples in %.3f s, %.1f Msamples/s\n", NUM_SAMPLES,
+         elapsed, NUM_SAMPLES / elapsed * 1e-6);
+
+  int failures = 0;
+  printf("%-10s %-12s %-12s\n", "tau [s]", "adev", "expected");
+  for (size_t k = 0U; k < 14U; ++k) {
+    const double adev = stability_adev(&s, k);
+    const double expected = SIGMA / sqrt(ldexp(1.0, (int)k));
+    const bool ok = fabs(adev - expected) < 0.1 * expected;
+    printf("%-10g %-12.4g %-12.4g%s\n", stability_tau(&s, k), adev, expected,
+           ok ? "" : " !");
+    failures += ok ? 0 : 1;
+  }
+  return failures;
+}
+
+static void bench_parse_and_analysis(void) {
+  static char text[NUM_SAMPLES / 4U * 16U];
+  size_t size = 0U;
+  for (size_t i = 0U; i < NUM_SAMPLES / 4U; ++i) {
+    const int count = 500000 + (int)(100.0 * gaussian());
+    size += (size_t)snprintf(&text[size], sizeof text - size,
+                             " %04d.%02dkHz\r\n", count / 100, count % 100);
+  }
+
+  static int32_t values[NUM_SAMPLES / 4U];
+  static int8_t exponents[NUM_SAMPLES / 4U];
+  static u8 flags[NUM_SAMPLES / 4U];
+  static u8 units[NUM_SAMPLES / 4U];
+  static struct stability s;
+  stability_init(&s, 0.01, 4990e3, 5010e3);
+  struct timespec start;
+  timespec_get(&start, TIME_UTC);
+  size_t consumed = 0U;
+  const size_t rows = parse_readings(
+      METER_1900A, text, size,
+      (struct reading_columns){values, exponents, flags, units},
+      NUM_SAMPLES / 4U, &consumed);
+  for (size_t i = 0U; i < rows; ++i) {
+    stability_add(&s, parsed_to_si(values[i], exponents[i], units[i]));
+  }
+  const double elapsed = seconds_since(&start);
+  printf("parse and analysis: %zu lines in %.3f s, %.1f Mlines/s\n", rows,
+         elapsed, (double)rows / elapsed * 1e-6);
+}
+
+int main(void) {
+  const int failures = bench_analysis();
+  bench_parse_and_analysis();
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
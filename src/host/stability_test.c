@@ -0,0 +1,41 @@
+// Tests the stability analysis with degenerate input.
+
+#include "stability.c"
+
+#include <unity.h>
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static struct stability stability_;
+
+static void test_constant_input(void) {
+  stability_init(&stability_, 0.1, 10e6, 10e6);
+  for (size_t i = 0U; i < 1000U; ++i) {
+    stability_add(&stability_, 10e6);
+  }
+  TEST_ASSERT_EQUAL_UINT64(1000U, stability_.histogram[0]);
+  TEST_ASSERT_EQUAL_UINT64(0U, stability_.below);
+  TEST_ASSERT_EQUAL_UINT64(0U, stability_.above);
+  TEST_ASSERT_TRUE(stability_adev(&stability_, 0U) == 0.0);
+  TEST_ASSERT_TRUE(stability_drift(&stability_) == 0.0);
+}
+
+static void test_inverted_range(void) {
+  stability_init(&stability_, 1.0, 1.0, -1.0);
+  stability_add(&stability_, -2.0);
+  stability_add(&stability_, 0.0);
+  stability_add(&stability_, 2.0);
+  TEST_ASSERT_EQUAL_UINT64(3U, stability_.histogram[0]);
+  for (size_t i = 1U; i < HISTOGRAM_BINS; ++i) {
+    TEST_ASSERT_EQUAL_UINT64(0U, stability_.histogram[i]);
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_constant_input);
+  RUN_TEST(test_inverted_range);
+  return UNITY_END();
+}
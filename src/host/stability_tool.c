@@ -0,0 +1,102 @@
+// Reads the output of a 1900A DOU from stdin and prints its frequency
+// stability, e.g. `stability 0.1 10e6 < burn_in.txt`.
+//
+// Arguments are the gate time τ0 in s and, optionally, the nominal value and
+// the half width of the histogram. With a nominal value, the analysis uses the
+// fractional deviation from it. The histogram is centered on the first sample.
+
+#include "stability.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHUNK_ROWS 4096U
+
+static char text_[CHUNK_ROWS * MAX_READING_SIZE];
+static int32_t values_[CHUNK_ROWS];
+static int8_t exponents_[CHUNK_ROWS];
+static u8 flags_[CHUNK_ROWS];
+static u8 units_[CHUNK_ROWS];
+
+static void print_results(const struct stability *s, const uint64_t skipped) {
+  printf("samples   %llu (%llu skipped)\n", (unsigned long long)s->count,
+         (unsigned long long)skipped);
+  printf("mean      %.9g\n", s->mean_y);
+  printf("min/max   %.9g / %.9g\n", s->min, s->max);
+  printf("drift     %.6g /s\n", stability_drift(s));
+  printf("\n%-12s %s\n", "tau [s]", "adev");
+  for (size_t k = 0U; k < STABILITY_LEVELS; ++k) {
+    const double adev = stability_adev(s, k);
+    if (!isnan(adev)) {
+      printf("%-12g %.6g\n", stability_tau(s, k), adev);
+    }
+  }
+  printf("\n%-14s %s\n", "bin", "count");
+  printf("%-14s %llu\n", "below", (unsigned long long)s->below);
+  for (size_t i = 0U; i < HISTOGRAM_BINS; ++i) {
+    if (s->histogram[i] != 0U) {
+      printf("%-14.8g %llu\n",
+             s->histogram_min + (double)i * s->histogram_width,
+             (unsigned long long)s->histogram[i]);
+    }
+  }
+  printf("%-14s %llu\n", "above", (unsigned long long)s->above);
+}
+
+int main(const int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <tau0 [s]> [nominal [span]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const double tau0 = strtod(argv[1], nullptr);
+  const double nominal = argc > 2 ? strtod(argv[2], nullptr) : 0.0;
+  const double span = argc > 3 ? strtod(argv[3], nullptr) : 1e-4;
+  if (!(span > 0.0)) {
+    fprintf(stderr, "span must be positive\n");
+    return EXIT_FAILURE;
+  }
+
+  static struct stability s;
+  bool initialized = false;
+  uint64_t skipped = 0U;
+  size_t size = 0U;
+  for (;;) {
+    const size_t num_read = fread(&text_[size], 1U, sizeof text_ - size, stdin);
+    size += num_read;
+    size_t consumed = 0U;
+    const size_t rows = parse_readings(
+        METER_1900A, text_, size,
+        (struct reading_columns){values_, exponents_, flags_, units_},
+        CHUNK_ROWS, &consumed);
+    for (size_t i = 0U; i < rows; ++i) {
+      if (flags_[i] != 0U) {
+        skipped += 1U;
+        continue;
+      }
+      double y = parsed_to_si(values_[i], exponents_[i], units_[i]);
+      if (nominal != 0.0) {
+        y = (y - nominal) / nominal;
+      }
+      if (!initialized) {
+        const double width = nominal != 0.0 ? span : fabs(y) * span + span;
+        stability_init(&s, tau0, y - width, y + width);
+        initialized = true;
+      }
+      stability_add(&s, y);
+    }
+    memmove(text_, &text_[consumed], size - consumed);
+    size -= consumed;
+    if (num_read == 0U) {
+      break;
+    }
+    if (size == sizeof text_) {
+      size = 0U; // garbage without line endings
+    }
+  }
+  if (!initialized) {
+    fprintf(stderr, "no readings\n");
+    return EXIT_FAILURE;
+  }
+  print_results(&s, skipped);
+  return EXIT_SUCCESS;
+}
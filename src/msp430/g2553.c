@@ -0,0 +1,66 @@
+// Start-up code and utilities for MSP430G2x53 MCUs, which have the USCI
+// instead of the USI.
+
+#include "g2xx.c"
+
+extern volatile u8 P1SEL2;
+extern volatile u8 P2SEL2;
+
+extern volatile u8 IE2;
+#define UCA0TXIE (0x02U) // enable the `usci_tx` interrupt
+#define UCA0RXIE (0x01U) // enable the `usci_rx` interrupt
+extern volatile u8 IFG2;
+#define UCA0TXIFG (0x02U) // the transmit buffer is empty
+#define UCA0RXIFG (0x01U) // a character has been received
+
+extern volatile u8 UCA0CTL0;
+#define UCSPB  (0x08U) // two stop bits
+#define UC7BIT (0x10U) // seven data bits
+extern volatile u8 UCA0CTL1;
+#define UCSSEL_SMCLK (0x80U)
+#define UCSWRST      (0x01U) // holds the USCI in reset, while it is set up
+extern volatile u8 UCA0BR0;
+extern volatile u8 UCA0BR1;
+extern volatile u8 UCA0MCTL;
+#define UCOS16 (0x01U) // oversampling
+extern volatile u8 UCA0STAT;
+#define UCBUSY (0x01U)
+extern INPUT_REGISTER u8 UCA0RXBUF;
+// The simulation sees the writes, as the buffer is wider there, see
+// `mcu_sim.c`.
+#ifdef MSP430_SIM
+extern volatile u16 UCA0TXBUF;
+#else
+extern volatile u8 UCA0TXBUF;
+#endif
+
+// The divider and the modulation of the UART with oversampling for the given
+// baud rate from a clock of the given frequency, i.e. the clock is divided by
+// 16 times `UCA0_BR` plus the `UCA0_BRF` of the first stage, rounded.
+#define UCA0_BR(frequency, rate) ((frequency) / (16U * (rate)))
+#define UCA0_BRF(frequency, rate)                                              \
+  (((frequency) + (rate) / 2U) / (rate) - 16U * UCA0_BR((frequency), (rate)))
+#define UCA0_MCTL(frequency, rate)                                             \
+  (UCA0_BRF((frequency), (rate)) << 4U | UCOS16)
+
+struct vtable {
+  vector unused_[16];
+  vector v16_;
+  vector v17_;
+  vector port1;
+  vector port2;
+  vector v20_;
+  vector adc10;
+  vector usci_tx; // USCI_A0 and USCI_B0
+  vector usci_rx; // USCI_A0 and USCI_B0
+  vector timer0_a3_2;
+  vector timer0_a3;
+  vector watchdog;
+  vector comparator;
+  vector timer1_a3_2;
+  vector timer1_a3;
+  vector nmi;
+  vector reset;
+};
+_Static_assert(sizeof(struct vtable) == 32 * sizeof(void *),
+               "vector table has unexpected size");
@@ -2,7 +2,14 @@
 
 #include "../dou.h"
 
-extern const volatile u8 P1IN;
+// The inputs are read-only, except for the simulation, see `mcu_sim.c`.
+#ifdef MSP430_SIM
+#define INPUT_REGISTER volatile
+#else
+#define INPUT_REGISTER const volatile
+#endif
+
+extern INPUT_REGISTER u8 P1IN;
 extern volatile u8 P1OUT;
 extern volatile u8 P1DIR;
 extern volatile u8 P1IFG;
@@ -11,7 +18,7 @@ extern volatile u8 P1IE;
 extern volatile u8 P1SEL;
 extern volatile u8 P1REN;
 
-extern const volatile u8 P2IN;
+extern INPUT_REGISTER u8 P2IN;
 extern volatile u8 P2OUT;
 extern volatile u8 P2DIR;
 extern volatile u8 P2IFG;
@@ -24,8 +31,10 @@ extern volatile u8 P2REN;
 #define PxIES_RISING_EDGE(x)  (0U)
 
 extern volatile u16 USICTL;
+#define USI_CKPH   (0x8000U) // capture on the first clock edge
 #define USI_IE     (0x1000U) // interrupt enable
 #define USI_IFG    (0x0100U) // interrupt flag
+#define USI_PE7    (0x0080U)
 #define USI_PE6    (0x0040U)
 #define USI_LSB    (0x0010U) // LSB first
 #define USI_MASTER (0x0008U)
@@ -40,16 +49,21 @@ extern volatile u8 USICNT;
 extern volatile u16 USISR;
 extern volatile u8 USISRL;
 
+extern volatile u8 IFG1;
+#define IFG1_WDT (0x01U) // set by a watchdog reset
+#define IFG1_RST (0x08U) // set by a reset from the RST pin
+
 extern volatile u8 BCSCTL3;
 extern volatile u8 DCOCTL;
 extern volatile u8 BCSCTL1;
+#define BCSCTL1_DIVA_8 (0x30U) // ACLK divided by 8
 
 extern volatile u16 WDTCTL;
 #define WDT_UNLOCK (0x5a00U)
 #define WDT_HOLD   (0x0080U)
 #define WDT_CLEAR  (0x0008U)
-#define WDT_ACLK   (0x0040U)
-#define WDT_32768  (0x0001U)
+#define WDT_ACLK   (0x0004U)
+#define WDT_32768  (0x0000U)
 #define WDT_8192   (0x0001U)
 #define WDT_512    (0x0002U)
 #define WDT_64     (0x0003U)
@@ -68,21 +82,26 @@ extern volatile u16 FCTL3;
 #define FCTL3_WAIT  (0x0008U)
 
 extern volatile u16 TACTL;
-#define TACTL_SMCLK (0x0200U)
-#define TACTL_UP    (0x0010U) // start counting up to TACCR0
+#define TACTL_ACLK       (0x0100U)
+#define TACTL_SMCLK      (0x0200U)
+#define TACTL_UP         (0x0010U) // start counting up to TACCR0
+#define TACTL_CONTINUOUS (0x0020U) // start counting up to 0xffff
+#define TACTL_CLEAR      (0x0004U)
 #define TACTL_START(mode)                                                      \
   do {                                                                         \
     TACTL |= (mode);                                                           \
   } while (0)
 #define TACTL_STOP()                                                           \
   do {                                                                         \
-    TACTL &= ~0x0030U;                                                         \
+    TACTL = (u16)(TACTL & ~0x0030U);                                           \
   } while (0)
 #define TACTL_IE  (0x0002U) // enable the `timer*_a3` interrupt
 #define TACTL_IFG (0x0001U) // flag for the `timer*_a3` interrupt
 extern volatile u16 TACCTL0;
 #define TACCTL0_OUTMODE_TOGGLE (0x0080U)
-extern const volatile u16 TAR;
+#define TACCTL0_CCIE           (0x0010U) // enable the CCR0 interrupt
+#define TACCTL0_CCIFG          (0x0001U) // flag for the CCR0 interrupt
+extern INPUT_REGISTER u16 TAR;
 extern volatile u16 TACCR0;
 
 extern const u8 CAL_DCO_16MHz;
@@ -90,6 +109,7 @@ extern const u8 CAL_BC1_16MHz;
 extern const u8 CAL_DCO_1MHz;
 extern const u8 CAL_BC1_1MHz;
 
+#ifndef MSP430_SIM
 extern int main(void);
 
 __attribute__((naked)) _Noreturn void on_reset(void) {
@@ -138,6 +158,13 @@ __attribute__((naked)) _Noreturn void on_reset(void) {
     __asm__ volatile("nop { bis %0, SR { nop" : : "ri"(0x10));                 \
   } while (0)
 
+// Enters LPM0 and enables interrupts with the same instruction, so that an
+// interrupt that is already pending wakes the CPU right away.
+#define go_to_sleep_enabling_interrupts()                                      \
+  do {                                                                         \
+    __asm__ volatile("nop { bis %0, SR { nop" : : "ri"(0x18));                 \
+  } while (0)
+
 #define stay_awake()                                                           \
   do {                                                                         \
     __bic_SR_register_on_exit(0x10);                                           \
@@ -153,4 +180,59 @@ __attribute__((naked)) _Noreturn void on_reset(void) {
     __asm__ volatile("dint { nop");                                            \
   } while (0)
 
+// Places a variable in RAM that is not initialized by `on_reset()`.
+#define NOINIT __attribute__((section(".noinit")))
+
+// Places a constant in the information memory, which is not programmed along
+// with the firmware. The first one starts segment D at 0x1000.
+#define INFO __attribute__((section(".info")))
+
+// Places a variable in main flash below the firmware, which is not programmed
+// along with it either, e.g. for a log. It starts a segment of 512 bytes, the
+// unit of `flash_erase()`.
+#define FLASH_LOG __attribute__((section(".log"), aligned(512)))
+
+// Erases the segment of main flash with the given word. `FCTL2` must give the
+// flash timing generator 257 to 476 kHz. The CPU stalls for about 12 ms.
+static void flash_erase(volatile u16 *segment) {
+  disable_interrupts();
+  FCTL3 = FLASH_KEY; // unlock, but leave segment A locked
+  FCTL1 = FLASH_KEY | FCTL1_ERASE;
+  *segment = 0U;
+  FCTL1 = FLASH_KEY;
+  FCTL3 = FLASH_KEY | FCTL3_LOCK;
+  enable_interrupts();
+}
+
+// Writes a word of erased main flash, i.e. only clears bits, see
+// `flash_erase()`. The CPU stalls for about 75 µs.
+static void flash_write(volatile u16 *word, const u16 value) {
+  disable_interrupts();
+  FCTL3 = FLASH_KEY;
+  FCTL1 = FLASH_KEY | FCTL1_WRITE;
+  *word = value;
+  FCTL1 = FLASH_KEY;
+  FCTL3 = FLASH_KEY | FCTL3_LOCK;
+  enable_interrupts();
+}
+
+#endif
+
 typedef void (*vector)(void);
+
+#ifdef MSP430_SIM
+#include "mcu_sim.c"
+#endif
+
+// Sleeps as long as the condition holds, which an ISR changes before it wakes
+// the CPU. The condition is tested with interrupts disabled, so that the ISR
+// cannot run between the test and the sleep, and its wakeup be lost.
+#define sleep_while(condition)                                                 \
+  do {                                                                         \
+    disable_interrupts();                                                      \
+    while (condition) {                                                        \
+      go_to_sleep_enabling_interrupts();                                       \
+      disable_interrupts();                                                    \
+    }                                                                          \
+    enable_interrupts();                                                       \
+  } while (0)
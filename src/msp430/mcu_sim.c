@@ -0,0 +1,676 @@
+// Simulates an MSP430G2xx well enough to run the firmware on the host, for
+// tests and profiles of the firmware as a whole. `g2xx.c` includes it instead
+// of the start-up code, if `MSP430_SIM` is defined, and the registers are plain
+// variables then.
+//
+// The CPU is infinitely fast, i.e. time only passes in LPM, or after a wakeup,
+// if the board says so, see `mcu_sleep()`, while the simulation moves on to the
+// next event: an edge of the inputs given to `mcu_run()`, the end of a USI
+// transfer or of a character that USCI_A0 sends as a UART, the end of a period
+// of Timer_A in up mode, or the expiry of the watchdog. Interrupts are
+// requested as by the hardware, but only serviced in `go_to_sleep()`,
+// `go_to_sleep_enabling_interrupts()` and `enable_interrupts()`, so a
+// busy-wait for an interrupt never ends.
+//
+// The simulation catches up with what the firmware wrote to the registers in
+// the meantime at these points, and in `disable_interrupts()`. E.g. a new count
+// in `USICNT` starts a transfer, and `TACTL_CLEAR` restarts the timer. As the
+// writes to `UCA0TXBUF` cannot be told from the previous value otherwise, it
+// is wider than a character here, and holds `MCU_USCI_EMPTY`, once the USCI
+// has taken the character.
+//
+// Not simulated are the other peripherals, e.g. the flash controller, which
+// `flash_erase()` and `flash_write()` stand in for, stalling the CPU as long as
+// it would, the clock system, which is assumed to run as configured by the
+// firmware, and the initialization of variables after a reset: a second run of
+// the firmware starts with the values it left.
+
+#include <setjmp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The attribute of the ISRs has no meaning on the host.
+#define interrupt used
+
+// A host program has its own `main()`.
+#define main firmware_main
+int main(void);
+
+#define NOINIT
+#define INFO
+#define FLASH_LOG __attribute__((aligned(MCU_FLASH_SEGMENT)))
+
+#define go_to_sleep()                     mcu_sleep()
+#define go_to_sleep_enabling_interrupts() mcu_sleep_enabling_interrupts()
+#define stay_awake()                      (mcu_.awake = true)
+#define enable_interrupts()               mcu_enable_interrupts()
+#define disable_interrupts()              mcu_disable_interrupts()
+
+volatile u8 P1IN;
+volatile u8 P1OUT;
+volatile u8 P1DIR;
+volatile u8 P1IFG;
+volatile u8 P1IES;
+volatile u8 P1IE;
+volatile u8 P1SEL;
+volatile u8 P1REN;
+volatile u8 P2IN;
+volatile u8 P2OUT;
+volatile u8 P2DIR;
+volatile u8 P2IFG;
+volatile u8 P2IES;
+volatile u8 P2IE;
+volatile u8 P2SEL;
+volatile u8 P2REN;
+volatile u16 USICTL;
+volatile u16 USICCTL;
+volatile u8 USICNT;
+volatile u16 USISR;
+volatile u8 USISRL;
+volatile u8 P1SEL2;
+volatile u8 P2SEL2;
+volatile u8 IE2;
+volatile u8 IFG2;
+volatile u8 UCA0CTL0;
+volatile u8 UCA0CTL1;
+volatile u8 UCA0BR0;
+volatile u8 UCA0BR1;
+volatile u8 UCA0MCTL;
+volatile u8 UCA0STAT;
+volatile u8 UCA0RXBUF;
+volatile u16 UCA0TXBUF;
+volatile u8 IFG1;
+volatile u8 BCSCTL3;
+volatile u8 DCOCTL;
+volatile u8 BCSCTL1;
+volatile u16 WDTCTL;
+volatile u16 FCTL1;
+volatile u16 FCTL2;
+volatile u16 FCTL3;
+volatile u16 TACTL;
+volatile u16 TACCTL0;
+volatile u16 TAR;
+volatile u16 TACCR0;
+const u8 CAL_DCO_16MHz = 0x95U;
+const u8 CAL_BC1_16MHz = 0x8fU;
+const u8 CAL_DCO_1MHz = 0x56U;
+const u8 CAL_BC1_1MHz = 0x86U;
+
+// Main flash is erased by segments, see `flash_erase()`.
+#define MCU_FLASH_SEGMENT 512U
+
+// The simulated time runs in ticks of a clock that divides into all others.
+#define MCU_TICKS_PER_US 48U
+#define MCU_SMCLK_TICKS  3U    // 16 MHz, as calibrated by the firmware
+#define MCU_VLOCLK_TICKS 4000U // 12 kHz, nominal
+#define MCU_DCO_TICKS    48U   // 1 MHz, after a reset
+
+// The vectors in the `struct vtable` of the firmware, by priority.
+enum mcu_vector {
+  MCU_PORT1 = 18,
+  MCU_PORT2 = 19,
+  MCU_USI = 20,
+  MCU_USCI_TX = 22,
+  MCU_TIMER = 25, // CCR0
+  MCU_RESET = 31
+};
+
+#define MCU_USI_COUNT   (0x1fU) // of `USICNT`
+#define MCU_USI_SSEL    (0x1cU) // clock source select in `USICCTL`
+#define MCU_USI_DIV(x)  (1U << (((x) >> 5U) & 7U))
+#define MCU_USI_PE7_PIN (0x80U) // SDI on P1.7
+#define MCU_USI_PE6_PIN (0x40U) // SDO on P1.6
+#define MCU_UCA0TXD_PIN (0x04U) // on P1.2
+#define MCU_UCA0TXIFG   (0x02U) // and `UCA0TXIE`
+#define MCU_UC7BIT      (0x10U)
+#define MCU_UCSPB       (0x08U)
+#define MCU_UCSWRST     (0x01U)
+#define MCU_UCOS16      (0x01U)
+#define MCU_USCI_EMPTY  (0x100U)
+#define MCU_WDT_LOCKED  (0x6900U)
+#define MCU_MAX_OUTPUT  (1U << 16U)
+
+// The state of the inputs from the given time on.
+struct mcu_edge {
+  uint64_t time; // µs
+  u8 port1;
+  u8 port2;
+};
+
+// How the simulated MCU is wired up.
+struct mcu_board {
+  const void *vectors; // the firmware's `struct vtable`
+  u8 tx_pin;           // of port 1, where the host receives
+  u32 baud_rate;       // at which the host receives
+  u8 probe_pin;        // of port 1, which is watched like a scope, or 0
+  u32 wakeup_us;       // the CPU takes after each wakeup, see `mcu_sleep()`
+};
+
+enum mcu_exit {
+  MCU_END,      // at the last edge
+  MCU_WATCHDOG, // the watchdog expired
+  MCU_FAULT,    // an interrupt without vector, or `main()` returned
+};
+
+static struct {
+  const struct mcu_board *board;
+  const vector *vectors;
+  const struct mcu_edge *edges;
+  size_t num_edges;
+  size_t next_edge;
+  uint64_t now; // ticks
+  bool interrupts_enabled;
+  bool awake; // leave LPM at the end of the ISR
+  jmp_buf exit;
+  enum mcu_exit exit_reason;
+
+  // Timer_A counts from `timer_count` on at `timer_since`.
+  u16 timer_control; // `TACTL`, as seen last
+  uint64_t timer_since;
+  uint64_t timer_count;
+
+  bool usi_busy;
+  uint64_t usi_start;
+  uint64_t usi_bit_ticks;
+
+  // USCI_A0 shifts out the bits of `usci_frame`, LSB first, clocked by SMCLK.
+  bool usci_busy;
+  uint64_t usci_start;
+  uint64_t usci_bit_ticks;
+  unsigned usci_frame;
+  unsigned usci_bits;
+
+  uint64_t watchdog_expiry; // or 0, if held
+
+  // The host receives the serial output like a UART, see `mcu_line()`.
+  bool line_level;
+  int line_bit; // being received, or -1
+  uint64_t line_start;
+  unsigned line_frame;
+  char output[MCU_MAX_OUTPUT];
+  size_t output_length;
+
+  // The pulses of the probe pin, as seen by `mcu_sync()`. A pulse within an
+  // ISR takes no time, so it is not seen.
+  bool probe_level;
+  uint64_t probe_since;
+  u32 probe_pulses;
+  uint64_t probe_ticks; // high
+
+  // statistics
+  uint64_t sleep_ticks;
+  u32 interrupts; // ISRs called
+  u32 serviced[32]; // ISRs called by `enum mcu_vector`
+  u32 wakeups;    // returns from `go_to_sleep()`
+  u32 flash_erases; // segments
+} mcu_;
+
+// Returns the ticks of the clock that is selected by the given bits of
+// `TACTL` or `WDTCTL`, ACLK or SMCLK.
+static uint64_t mcu_clock_ticks(const bool aclk) {
+  return aclk ? (uint64_t)MCU_VLOCLK_TICKS << ((BCSCTL1 >> 4U) & 3U)
+              : MCU_SMCLK_TICKS;
+}
+
+static uint64_t mcu_timer_ticks(void) {
+  return mcu_clock_ticks((mcu_.timer_control & TACTL_ACLK) != 0U);
+}
+
+static unsigned mcu_timer_mode(void) {
+  return (mcu_.timer_control >> 4U) & 3U;
+}
+
+// Returns the count of the timer at the given time, not wrapped.
+static uint64_t mcu_timer_count(const uint64_t time) {
+  if (mcu_timer_mode() == 0U) {
+    return mcu_.timer_count;
+  }
+  return mcu_.timer_count + (time - mcu_.timer_since) / mcu_timer_ticks();
+}
+
+static u16 mcu_timer_wrap(const uint64_t count) {
+  return (u16)(mcu_timer_mode() == 1U ? count % (TACCR0 + 1U) : count);
+}
+
+// Returns the time of the next end of a period in up mode, or 0.
+static uint64_t mcu_timer_period_end(void) {
+  if (mcu_timer_mode() != 1U) {
+    return 0U;
+  }
+  const uint64_t period = TACCR0 + 1U;
+  const uint64_t count = mcu_timer_count(mcu_.now);
+  const uint64_t next = (count / period + 1U) * period;
+  return mcu_.timer_since + (next - mcu_.timer_count) * mcu_timer_ticks();
+}
+
+// Receives the serial output like a UART does: the line has had the given
+// level since the given time.
+static void mcu_line(const uint64_t time, const bool level) {
+  const u32 baud_rate = mcu_.board->baud_rate;
+  while (mcu_.line_bit >= 0) {
+    // in the middle of the bit
+    const uint64_t sample =
+        mcu_.line_start + (2U * (uint64_t)mcu_.line_bit + 1U) *
+                              MCU_TICKS_PER_US * 1000000U / (2U * baud_rate);
+    if (sample >= time) {
+      break;
+    }
+    mcu_.line_frame |= (mcu_.line_level ? 1U : 0U) << mcu_.line_bit;
+    if (++mcu_.line_bit == SERIAL_DATA_BITS + 2) {
+      if ((mcu_.line_frame & (STOP_BIT | 1U)) == STOP_BIT &&
+          mcu_.output_length < MCU_MAX_OUTPUT - 1U) {
+        mcu_.output[mcu_.output_length++] =
+            (char)((mcu_.line_frame >> 1U) & 0x7fU);
+      }
+      mcu_.line_bit = -1;
+    }
+  }
+  if (mcu_.line_bit < 0 && mcu_.line_level && !level) {
+    mcu_.line_bit = 0;
+    mcu_.line_start = time;
+    mcu_.line_frame = 0U;
+  }
+  mcu_.line_level = level;
+}
+
+// Returns the inputs at the given time.
+static const struct mcu_edge *mcu_edge_at(const uint64_t time) {
+  size_t i = mcu_.next_edge;
+  for (; i > 0U && mcu_.edges[i - 1U].time * MCU_TICKS_PER_US > time; --i) {
+  }
+  return &mcu_.edges[i > 0U ? i - 1U : 0U];
+}
+
+// Returns the time at which the given bit of the USI transfer is sampled, on
+// the first edge of the clock with `USI_CKPH`, i.e. half a bit into it, or else
+// on the second one.
+static uint64_t mcu_usi_sample(const unsigned bit) {
+  return mcu_.usi_start + bit * mcu_.usi_bit_ticks +
+         ((USICTL & USI_CKPH) != 0U ? mcu_.usi_bit_ticks / 2U
+                                    : mcu_.usi_bit_ticks);
+}
+
+// Returns the time of the end of the USI transfer, i.e. of the last sample,
+// or 0.
+static uint64_t mcu_usi_end(void) {
+  const unsigned bits = USICNT & MCU_USI_COUNT;
+  return mcu_.usi_busy && bits > 0U ? mcu_usi_sample(bits - 1U) : 0U;
+}
+
+// Shifts the bits of the transfer out to SDO and in from SDI.
+static void mcu_usi_finish(void) {
+  const unsigned bits = USICNT & MCU_USI_COUNT;
+  const bool word = (USICNT & USI_16BIT) != 0U;
+  const unsigned top = word ? 15U : 7U;
+  unsigned shift = word ? USISR : USISRL;
+  const bool out = (USICTL & (USI_PE6 | USI_OE)) == (USI_PE6 | USI_OE) &&
+                   (P1SEL & MCU_USI_PE6_PIN) != 0U;
+  const bool lsb = (USICTL & USI_LSB) != 0U;
+  for (unsigned i = 0U; i < bits; ++i) {
+    const uint64_t time = mcu_.usi_start + i * mcu_.usi_bit_ticks;
+    if (out && mcu_.board->tx_pin == MCU_USI_PE6_PIN) {
+      mcu_line(time, ((lsb ? shift : shift >> top) & 1U) != 0U);
+    }
+    const unsigned in =
+        (USICTL & USI_PE7) != 0U &&
+                (mcu_edge_at(mcu_usi_sample(i))->port1 & MCU_USI_PE7_PIN) != 0U
+            ? 1U
+            : 0U;
+    shift = lsb ? shift >> 1U | in << top
+                : (shift << 1U | in) & ((2U << top) - 1U);
+  }
+  if (word) {
+    USISR = (u16)shift;
+  } else {
+    USISRL = (u8)shift;
+  }
+  USICNT = (u8)(USICNT & ~MCU_USI_COUNT);
+  USICTL |= USI_IFG;
+  mcu_.usi_busy = false;
+}
+
+// Returns the time of the end of the character that USCI_A0 sends, or 0.
+static uint64_t mcu_usci_end(void) {
+  return mcu_.usci_busy
+             ? mcu_.usci_start + mcu_.usci_bits * mcu_.usci_bit_ticks
+             : 0U;
+}
+
+// Moves the character from the transmit buffer to the shift register, if
+// there is one, and the USCI is idle.
+static void mcu_usci_load(void) {
+  if (mcu_.usci_busy || UCA0TXBUF == MCU_USCI_EMPTY ||
+      (UCA0CTL1 & MCU_UCSWRST) != 0U) {
+    return;
+  }
+  const unsigned data_bits = (UCA0CTL0 & MCU_UC7BIT) != 0U ? 7U : 8U;
+  const unsigned stop_bits = (UCA0CTL0 & MCU_UCSPB) != 0U ? 2U : 1U;
+  const unsigned data = UCA0TXBUF & ((1U << data_bits) - 1U);
+  mcu_.usci_frame = data << 1U | ((1U << stop_bits) - 1U) << (data_bits + 1U);
+  mcu_.usci_bits = 1U + data_bits + stop_bits;
+  // the modulation of the first stage evens out within a character
+  const unsigned divider = (unsigned)UCA0BR1 << 8U | UCA0BR0;
+  mcu_.usci_bit_ticks =
+      MCU_SMCLK_TICKS * ((UCA0MCTL & MCU_UCOS16) != 0U
+                             ? 16U * divider + (UCA0MCTL >> 4U)
+                             : divider);
+  mcu_.usci_start = mcu_.now;
+  mcu_.usci_busy = true;
+  UCA0TXBUF = MCU_USCI_EMPTY;
+  IFG2 |= MCU_UCA0TXIFG;
+}
+
+// Shifts the character out to TXD and takes the next one.
+static void mcu_usci_finish(void) {
+  const bool out = (P1SEL & P1SEL2 & MCU_UCA0TXD_PIN) != 0U &&
+                   mcu_.board->tx_pin == MCU_UCA0TXD_PIN;
+  for (unsigned i = 0U; out && i < mcu_.usci_bits; ++i) {
+    mcu_line(mcu_.usci_start + i * mcu_.usci_bit_ticks,
+             ((mcu_.usci_frame >> i) & 1U) != 0U);
+  }
+  mcu_.usci_busy = false;
+  mcu_usci_load();
+}
+
+// Catches up with what the firmware wrote to the registers.
+static void mcu_sync(void) {
+  if ((WDTCTL & 0xff00U) == WDT_UNLOCK) {
+    const bool held = mcu_.watchdog_expiry == 0U;
+    if ((WDTCTL & WDT_HOLD) != 0U) {
+      mcu_.watchdog_expiry = 0U;
+    } else if ((WDTCTL & WDT_CLEAR) != 0U || held) {
+      static const uint64_t intervals[4] = {32768U, 8192U, 512U, 64U};
+      mcu_.watchdog_expiry =
+          mcu_.now + intervals[WDTCTL & 3U] *
+                         mcu_clock_ticks((WDTCTL & WDT_ACLK) != 0U);
+    }
+    WDTCTL = (u16)(MCU_WDT_LOCKED | (WDTCTL & 0xffU & ~WDT_CLEAR));
+  }
+
+  if (TACTL != mcu_.timer_control) {
+    mcu_.timer_count = mcu_timer_wrap(mcu_timer_count(mcu_.now));
+    if ((TACTL & TACTL_CLEAR) != 0U) {
+      mcu_.timer_count = 0U;
+      TACTL = (u16)(TACTL & ~TACTL_CLEAR);
+    }
+    mcu_.timer_since = mcu_.now;
+    mcu_.timer_control = TACTL;
+  }
+  TAR = mcu_timer_wrap(mcu_timer_count(mcu_.now));
+
+  if (!mcu_.usi_busy && (USICNT & MCU_USI_COUNT) != 0U &&
+      (USICTL & USI_RESET) == 0U) {
+    mcu_.usi_busy = true;
+    mcu_.usi_start = mcu_.now;
+    // one bit per period of the output of CCR0 in toggle mode
+    mcu_.usi_bit_ticks =
+        (USICCTL & MCU_USI_SSEL) == (USI_TACCR0 & MCU_USI_SSEL)
+            ? 2U * (TACCR0 + 1U) * mcu_timer_ticks()
+            : MCU_SMCLK_TICKS * MCU_USI_DIV(USICCTL);
+    USICTL = (u16)(USICTL & ~USI_IFG);
+  }
+
+  if (UCA0TXBUF != MCU_USCI_EMPTY) {
+    IFG2 = (u8)(IFG2 & ~MCU_UCA0TXIFG); // by the write
+    mcu_usci_load();
+  }
+
+  if ((P1SEL & mcu_.board->tx_pin) == 0U) {
+    mcu_line(mcu_.now, (P1OUT & mcu_.board->tx_pin) != 0U);
+  }
+
+  const bool probe = (P1OUT & P1DIR & mcu_.board->probe_pin) != 0U;
+  if (probe && !mcu_.probe_level) {
+    mcu_.probe_pulses += 1U;
+    mcu_.probe_since = mcu_.now;
+  } else if (!probe && mcu_.probe_level) {
+    mcu_.probe_ticks += mcu_.now - mcu_.probe_since;
+  }
+  mcu_.probe_level = probe;
+}
+
+static _Noreturn void mcu_exit(const enum mcu_exit reason) {
+  mcu_.exit_reason = reason;
+  longjmp(mcu_.exit, 1);
+}
+
+// Returns the pending interrupt with the highest priority, or 0.
+static enum mcu_vector mcu_pending(void) {
+  if ((TACCTL0 & (TACCTL0_CCIE | TACCTL0_CCIFG)) ==
+      (TACCTL0_CCIE | TACCTL0_CCIFG)) {
+    return MCU_TIMER;
+  }
+  if ((IE2 & IFG2 & MCU_UCA0TXIFG) != 0U) {
+    return MCU_USCI_TX;
+  }
+  if ((USICTL & (USI_IE | USI_IFG)) == (USI_IE | USI_IFG)) {
+    return MCU_USI;
+  }
+  if ((P2IFG & P2IE) != 0U) {
+    return MCU_PORT2;
+  }
+  if ((P1IFG & P1IE) != 0U) {
+    return MCU_PORT1;
+  }
+  return 0;
+}
+
+// Calls the ISRs of the pending interrupts.
+static void mcu_service(void) {
+  while (mcu_.interrupts_enabled) {
+    mcu_sync();
+    const enum mcu_vector v = mcu_pending();
+    if (v == 0) {
+      break;
+    }
+    if (mcu_.vectors[v] == nullptr) {
+      mcu_exit(MCU_FAULT);
+    }
+    if (v == MCU_TIMER) {
+      // cleared by the hardware, as the interrupt has a vector of its own
+      TACCTL0 = (u16)(TACCTL0 & ~TACCTL0_CCIFG);
+    }
+    mcu_.interrupts += 1U;
+    mcu_.serviced[v] += 1U;
+    mcu_.interrupts_enabled = false;
+    mcu_.vectors[v]();
+    mcu_.interrupts_enabled = true;
+  }
+  mcu_sync();
+}
+
+static void mcu_apply_edge(const struct mcu_edge *e) {
+  // `PxIES` selects the falling edge of a pin, if set
+  const unsigned rise1 = (unsigned)~P1IN & e->port1;
+  const unsigned fall1 = P1IN & ~(unsigned)e->port1;
+  P1IFG = (u8)(P1IFG | (rise1 & ~(unsigned)P1IES) | (fall1 & P1IES));
+  const unsigned rise2 = (unsigned)~P2IN & e->port2;
+  const unsigned fall2 = P2IN & ~(unsigned)e->port2;
+  P2IFG = (u8)(P2IFG | (rise2 & ~(unsigned)P2IES) | (fall2 & P2IES));
+  P1IN = e->port1;
+  P2IN = e->port2;
+}
+
+static void mcu_earliest(uint64_t *next, const uint64_t time) {
+  if (time != 0U && time < *next) {
+    *next = time;
+  }
+}
+
+// Moves on to the next event, in LPM, or while the CPU is busy up to the given
+// time, if not 0.
+static void mcu_advance(const uint64_t limit) {
+  if (limit == 0U && mcu_.next_edge == mcu_.num_edges) {
+    mcu_exit(MCU_END);
+  }
+  uint64_t next = UINT64_MAX;
+  if (mcu_.next_edge < mcu_.num_edges) {
+    next = mcu_.edges[mcu_.next_edge].time * MCU_TICKS_PER_US;
+  }
+  mcu_earliest(&next, limit);
+  mcu_earliest(&next, mcu_usi_end());
+  mcu_earliest(&next, mcu_usci_end());
+  mcu_earliest(&next, mcu_timer_period_end());
+  mcu_earliest(&next, mcu_.watchdog_expiry);
+  if (next < mcu_.now) {
+    next = mcu_.now; // an edge in the past, e.g. the first one
+  }
+
+  if (limit == 0U) {
+    mcu_.sleep_ticks += next - mcu_.now;
+  }
+  mcu_.now = next;
+  if (mcu_.watchdog_expiry != 0U && mcu_.watchdog_expiry <= next) {
+    IFG1 |= IFG1_WDT;
+    mcu_exit(MCU_WATCHDOG);
+  }
+  for (; mcu_.next_edge < mcu_.num_edges &&
+         mcu_.edges[mcu_.next_edge].time * MCU_TICKS_PER_US <= next;
+       ++mcu_.next_edge) {
+    mcu_apply_edge(&mcu_.edges[mcu_.next_edge]);
+  }
+  if (mcu_.usi_busy && mcu_usi_end() <= next) {
+    mcu_usi_finish();
+  }
+  if (mcu_.usci_busy && mcu_usci_end() <= next) {
+    mcu_usci_finish();
+  }
+  if (mcu_timer_mode() == 1U &&
+      mcu_timer_wrap(mcu_timer_count(next)) == 0U) {
+    TACCTL0 |= TACCTL0_CCIFG;
+  }
+}
+
+// Lets the given time pass, while the CPU is busy, and calls the ISRs of the
+// interrupts as they come.
+static void mcu_busy(const uint64_t ticks) {
+  const uint64_t end = mcu_.now + ticks;
+  while (mcu_.now < end) {
+    mcu_advance(end);
+    mcu_service();
+  }
+}
+
+// The CPU takes no time otherwise, but it does after a wakeup, if the board
+// says so, i.e. for the wakeup itself, the rest of the ISR, and `main()` up to
+// where it reads the inputs. The edges that come meanwhile are applied.
+static void mcu_sleep(void) {
+  mcu_.awake = false;
+  for (;;) {
+    mcu_service();
+    if (mcu_.awake) {
+      break;
+    }
+    mcu_advance(0U);
+  }
+  mcu_.wakeups += 1U;
+  mcu_busy((uint64_t)mcu_.board->wakeup_us * MCU_TICKS_PER_US);
+}
+
+static void mcu_sleep_enabling_interrupts(void) {
+  mcu_.interrupts_enabled = true;
+  mcu_sleep();
+}
+
+static void mcu_enable_interrupts(void) {
+  mcu_.interrupts_enabled = true;
+  mcu_service();
+}
+
+static void mcu_disable_interrupts(void) {
+  mcu_.interrupts_enabled = false;
+  mcu_sync();
+}
+
+// Stalls the CPU, with interrupts disabled, for the given number of cycles of
+// the flash timing generator, which runs from SMCLK, divided as in `FCTL2`.
+static void mcu_flash_stall(const unsigned cycles) {
+  const bool enabled = mcu_.interrupts_enabled;
+  mcu_disable_interrupts();
+  mcu_busy((uint64_t)cycles * ((FCTL2 & 0x3fU) + 1U) * MCU_SMCLK_TICKS);
+  if (enabled) {
+    mcu_enable_interrupts();
+  }
+}
+
+// Main flash is ordinary memory, which keeps its content from run to run, as
+// it does on the MCU. Its erased state, that writes only clear bits, and the
+// time it takes are simulated. So it can only be written while the firmware
+// runs.
+static void flash_erase(volatile u16 *segment) {
+  mcu_flash_stall(4819U); // the segment erase time of the data sheet
+  volatile u16 *word = (volatile u16 *)((uintptr_t)segment &
+                                        ~(uintptr_t)(MCU_FLASH_SEGMENT - 1U));
+  for (size_t i = 0U; i < MCU_FLASH_SEGMENT / sizeof *word; ++i) {
+    word[i] = 0xffffU;
+  }
+  mcu_.flash_erases += 1U;
+}
+
+static void flash_write(volatile u16 *word, const u16 value) {
+  mcu_flash_stall(30U); // the word program time
+  *word = *word & value;
+}
+
+void on_reset(void) { main(); }
+
+// Runs the firmware from a reset, until the inputs end with the last edge,
+// which should be well after the last event of interest. The serial output is
+// collected in `mcu_.output`.
+static enum mcu_exit mcu_run(const struct mcu_board *board,
+                             const struct mcu_edge *edges,
+                             const size_t num_edges) {
+  mcu_.board = board;
+  mcu_.vectors = board->vectors;
+  mcu_.edges = edges;
+  mcu_.num_edges = num_edges;
+  mcu_.next_edge = 0U;
+  mcu_.now = 0U;
+  mcu_.interrupts_enabled = false;
+  mcu_.timer_control = 0U;
+  mcu_.timer_since = 0U;
+  mcu_.timer_count = 0U;
+  mcu_.usi_busy = false;
+  mcu_.usci_busy = false;
+  mcu_.line_level = true;
+  mcu_.line_bit = -1;
+  mcu_.output_length = 0U;
+  mcu_.probe_level = false;
+  mcu_.probe_pulses = 0U;
+  mcu_.probe_ticks = 0U;
+  mcu_.sleep_ticks = 0U;
+  mcu_.interrupts = 0U;
+  for (size_t i = 0U; i < 32U; ++i) {
+    mcu_.serviced[i] = 0U;
+  }
+  mcu_.wakeups = 0U;
+  mcu_.flash_erases = 0U;
+
+  // as after a power-up clear, but `IFG1` is kept for a watchdog reset
+  P1OUT = P1DIR = P1IFG = P1IES = P1IE = P1SEL = P1REN = 0U;
+  P2OUT = P2DIR = P2IFG = P2IES = P2IE = P2REN = 0U;
+  P2SEL = 0xc0U;
+  P1IN = num_edges > 0U ? edges[0].port1 : 0U;
+  P2IN = num_edges > 0U ? edges[0].port2 : 0U;
+  USICTL = USI_RESET;
+  USICCTL = USISR = 0U;
+  USICNT = USISRL = 0U;
+  P1SEL2 = P2SEL2 = IE2 = 0U;
+  IFG2 = MCU_UCA0TXIFG;
+  UCA0CTL0 = UCA0BR0 = UCA0BR1 = UCA0MCTL = UCA0STAT = UCA0RXBUF = 0U;
+  UCA0CTL1 = MCU_UCSWRST;
+  UCA0TXBUF = MCU_USCI_EMPTY;
+  TACTL = TACCTL0 = TAR = TACCR0 = 0U;
+  BCSCTL1 = 0x87U;
+  BCSCTL3 = 0x05U;
+  WDTCTL = MCU_WDT_LOCKED;
+  mcu_.watchdog_expiry = 32768U * MCU_DCO_TICKS;
+
+  if (setjmp(mcu_.exit) == 0) {
+    mcu_.vectors[MCU_RESET]();
+    mcu_.exit_reason = MCU_FAULT;
+  }
+  mcu_line(mcu_.now, mcu_.line_level);
+  mcu_.output[mcu_.output_length] = '\0';
+  return mcu_.exit_reason;
+}
@@ -0,0 +1,167 @@
+// Conversion of packed BCD readings to SI-normalized binary values, so that
+// binary output formats and host-side analysis need no string round-trip.
+// (Meant to be included after `dou.c`.)
+
+#include "dou.h"
+
+enum si_unit { SI_NONE, SI_SECOND, SI_HERTZ, SI_INVALID };
+
+// The reading is `value * 10^exponent` in `unit`.
+struct si_value {
+  i32 value;
+  i8 exponent;
+  u8 unit; // `enum si_unit`
+};
+
+// Converts up to eight packed BCD digits to binary, a digit per step, which
+// multiplies by ten with shifts, as the MSP430 has no multiplier.
+// Returns a negative value, if any nibble is not a decimal digit.
+static i32 bcd_to_binary(u32 bcd) {
+  u32 value = 0U;
+  for (int i = 0; i < 8; ++i, bcd <<= 4U) {
+    const u32 digit = bcd >> 28U;
+    if (digit > 9U) {
+      return -1;
+    }
+    value = (value << 3U) + (value << 1U) + digit;
+  }
+  return (i32)value;
+}
+
+// Converts a packed BCD reading, which may contain a `DECIMAL_POINT_BCD`
+// nibble, to `reading * 10^exponent` in `unit`.
+static struct si_value si_from_bcd(u32 bcd, int exponent,
+                                   const enum si_unit unit) {
+  // drop the decimal point and scale accordingly
+  for (unsigned i = 0U; i < 8U; ++i) {
+    if (((bcd >> (4U * i)) & 0xfU) == DECIMAL_POINT_BCD) {
+      const u32 below = bcd & (((u32)1U << (4U * i)) - 1U);
+      bcd = ((bcd >> (4U * i) >> 4U) << (4U * i)) | below;
+      exponent -= (int)i;
+      break;
+    }
+  }
+  const i32 value = bcd_to_binary(bcd);
+  if (value < 0) {
+    return (struct si_value){0, 0, SI_INVALID};
+  }
+  return (struct si_value){value, (i8)exponent, unit};
+}
+
+// The unit suffixes of SCPI.
+static const char si_unit_suffixes_[4][3] = {
+    [SI_NONE] = "", [SI_SECOND] = "S", [SI_HERTZ] = "HZ", [SI_INVALID] = ""};
+
+// sign + 8 digits + point + exponent
+#define MAX_NR3_SIZE (1 + 8 + 1 + 4)
+
+// Prints the value in the NR3 notation of SCPI, e.g. `+1.234E+06`, with all
+// significant digits of the reading. Like SCPI instruments do, an overload is
+// given as ±9.9E+37 and an invalid reading as 9.91E+37, i.e. not a number.
+static char *print_nr3(char *const begin, const char *end,
+                       const struct si_value v, const bool overload) {
+  if (v.unit == SI_INVALID) {
+    return print_str(begin, end, "+9.91E+37");
+  }
+  char *dst = print_str(begin, end, v.value < 0 ? "-" : "+");
+  if (overload) {
+    return print_str(dst, end, "9.9E+37");
+  }
+  if (end - dst < MAX_NR3_SIZE - 1) {
+    return dst;
+  }
+  // print the digits one place to the right and move the first one in front
+  // of the decimal point
+  const u32 magnitude = (u32)(v.value < 0 ? -v.value : v.value);
+  const char *digits_end = print_uint(&dst[1], end, magnitude);
+  const int num_digits = (int)(digits_end - &dst[1]);
+  dst[0] = dst[1];
+  dst[1] = '.';
+  dst += num_digits > 1 ? num_digits + 1 : 1;
+
+  const int exponent = v.exponent + num_digits - 1;
+  dst = print_str(dst, end, exponent < 0 ? "E-" : "E+");
+  const unsigned exponent_magnitude = (unsigned)(exponent < 0 ? -exponent
+                                                              : exponent);
+  dst = print_str(dst, end, exponent_magnitude < 10U ? "0" : "");
+  return print_uint(dst, end, exponent_magnitude);
+}
+
+// sequence, timestamp, value, unit + line ending + terminator
+#define MAX_CSV_SIZE (5 + 1 + 10 + 1 + MAX_NR3_SIZE + 1 + 2 + 2 + 1)
+
+// Prints the sequence number and timestamp of the reading, followed by its
+// value and unit, e.g. `42,123456,+1.234E+06,HZ`.
+static char *print_csv(char *const begin, const char *end, const u16 sequence,
+                       const u32 timestamp, const struct si_value v,
+                       const bool overload) {
+  char *dst = print_uint(begin, end, sequence);
+  dst = print_str(dst, end, ",");
+  dst = print_uint(dst, end, timestamp);
+  dst = print_str(dst, end, ",");
+  dst = print_nr3(dst, end, v, overload);
+  dst = print_str(dst, end, ",");
+  return print_str(dst, end, si_unit_suffixes_[v.unit]);
+}
+
+// Prints the value of the reading, followed by its unit, if any, e.g.
+// `+1.234E+06 HZ`.
+static char *print_scpi(char *const begin, const char *end,
+                        const struct si_value v, const bool overload) {
+  char *dst = print_nr3(begin, end, v, overload);
+  if (si_unit_suffixes_[v.unit][0] != '\0') {
+    dst = print_str(dst, end, " ");
+    dst = print_str(dst, end, si_unit_suffixes_[v.unit]);
+  }
+  return dst;
+}
+
+// Averages blocks of 2^n values. A block starts over, when the exponent or
+// unit changes, e.g. with the range, which includes invalid values, as they
+// have a unit of their own. It is overloaded, if any of its values is.
+struct si_average {
+  i32 sum;
+  u8 count;
+  bool overload;
+  struct si_value last;
+};
+
+// Adds the value to the block and returns true, if the block is complete. Then
+// `mean` and `overload` are set and the next block is started.
+static bool si_average_add(struct si_average *a, const struct si_value v,
+                           const bool overload, const unsigned log2_count,
+                           struct si_value *mean, bool *mean_overload) {
+  if (a->count == 0U || v.exponent != a->last.exponent ||
+      v.unit != a->last.unit) {
+    *a = (struct si_average){0, 0U, false, v};
+  }
+  a->sum += v.value;
+  a->count += 1U;
+  a->overload = a->overload || overload;
+  if (a->count < 1U << log2_count) {
+    return false;
+  }
+  // The MSP430 has no divider, but the count is a power of two.
+  const i32 magnitude = (i32)((u32)(a->sum < 0 ? -a->sum : a->sum) >>
+                              log2_count);
+  *mean = (struct si_value){a->sum < 0 ? -magnitude : magnitude, v.exponent,
+                            v.unit};
+  *mean_overload = a->overload;
+  a->count = 0U;
+  return true;
+}
+
+// Prints the value in the given format, which must not be `FORMAT_FIXED`,
+// including the line ending.
+static char *print_value(char buf[static MAX_CSV_SIZE],
+                         const enum output_format format,
+                         const struct si_value v, const bool overload,
+                         const u16 sequence, const u32 timestamp) {
+  const char *end = &buf[MAX_CSV_SIZE - 1];
+  char *dst = format == FORMAT_CSV
+                  ? print_csv(buf, end, sequence, timestamp, v, overload)
+                  : print_scpi(buf, end, v, overload);
+  dst = print_str(dst, end, "\r\n");
+  *dst = '\0';
+  return dst;
+}
@@ -0,0 +1,146 @@
+// Tests the conversion of packed BCD readings to SI-normalized values.
+
+#include "1900a.c"
+
+#include <unity.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_bcd_to_binary(void) {
+  TEST_ASSERT_EQUAL_INT32(0, bcd_to_binary(0x0U));
+  TEST_ASSERT_EQUAL_INT32(99999999, bcd_to_binary(0x99999999U));
+  TEST_ASSERT_EQUAL_INT32(12345678, bcd_to_binary(0x12345678U));
+  TEST_ASSERT_EQUAL_INT32(907, bcd_to_binary(0x907U));
+  TEST_ASSERT_EQUAL_INT32(-1, bcd_to_binary(0x90aU));
+  TEST_ASSERT_EQUAL_INT32(-1, bcd_to_binary(0xf0000000U));
+}
+
+void test_reading_to_si(void) {
+  // 001.234 MHz
+  struct si_value value = reading_to_si(0x001b234U, MHz);
+  TEST_ASSERT_EQUAL_INT32(1234, value.value);
+  TEST_ASSERT_EQUAL_INT8(3, value.exponent);
+  TEST_ASSERT_EQUAL_UINT8(SI_HERTZ, value.unit);
+
+  // 12345.6 us
+  value = reading_to_si(0x12345b6U, us);
+  TEST_ASSERT_EQUAL_INT32(123456, value.value);
+  TEST_ASSERT_EQUAL_INT8(-7, value.exponent);
+  TEST_ASSERT_EQUAL_UINT8(SI_SECOND, value.unit);
+
+  // .000100 ms
+  value = reading_to_si(0xb000100U, ms);
+  TEST_ASSERT_EQUAL_INT32(100, value.value);
+  TEST_ASSERT_EQUAL_INT8(-9, value.exponent);
+
+  // counts, no decimal point
+  value = reading_to_si(0x123456U, NoUnit);
+  TEST_ASSERT_EQUAL_INT32(123456, value.value);
+  TEST_ASSERT_EQUAL_INT8(0, value.exponent);
+  TEST_ASSERT_EQUAL_UINT8(SI_NONE, value.unit);
+
+  // a nibble that is neither digit nor decimal point
+  value = reading_to_si(0x12e456U, NoUnit);
+  TEST_ASSERT_EQUAL_UINT8(SI_INVALID, value.unit);
+}
+
+void test_print_nr3(void) {
+  char buffer[MAX_NR3_SIZE + 1];
+  const char *end = &buffer[MAX_NR3_SIZE];
+
+  // 001.234 MHz
+  *print_nr3(buffer, end, reading_to_si(0x001b234U, MHz), false) = '\0';
+  TEST_ASSERT_EQUAL_STRING("+1.234E+06", buffer);
+
+  // .000100 ms
+  *print_nr3(buffer, end, reading_to_si(0xb000100U, ms), false) = '\0';
+  TEST_ASSERT_EQUAL_STRING("+1.00E-07", buffer);
+
+  // 5 ms
+  *print_nr3(buffer, end, reading_to_si(0x000005bU, ms), false) = '\0';
+  TEST_ASSERT_EQUAL_STRING("+5E-03", buffer);
+
+  *print_nr3(buffer, end, (struct si_value){-99999999, 10, SI_NONE}, false) =
+      '\0';
+  TEST_ASSERT_EQUAL_STRING("-9.9999999E+17", buffer);
+
+  *print_nr3(buffer, end, reading_to_si(0x999999U, NoUnit), true) = '\0';
+  TEST_ASSERT_EQUAL_STRING("+9.9E+37", buffer);
+
+  *print_nr3(buffer, end, reading_to_si(0x12e456U, NoUnit), false) = '\0';
+  TEST_ASSERT_EQUAL_STRING("+9.91E+37", buffer);
+}
+
+void test_print_output(void) {
+  char buffer[MAX_OUTPUT_SIZE];
+  struct config config = {CONFIG_MAGIC, FORMAT_CSV, 1U, 0U,
+                          0U,           BURST_SIZE, 0U, 0U};
+  struct si_average average = {0, 0U, false, {0, 0, SI_NONE}};
+  struct burst burst = {0U, 0U, 0U, 0U, 0U};
+  print_output(buffer, &config, &average, &burst, 0x12345b6U, 1, false, us,
+               7U, 1500U);
+  TEST_ASSERT_EQUAL_STRING("7,1500,+1.23456E-02,S\r\n", buffer);
+
+  config.format = FORMAT_SCPI;
+  print_output(buffer, &config, &average, &burst, 0x001b234U, 4, false, MHz,
+               0U, 0U);
+  TEST_ASSERT_EQUAL_STRING("+1.234E+06 HZ\r\n", buffer);
+
+  print_output(buffer, &config, &average, &burst, 0x123456U, 0, true, NoUnit,
+               0U, 0U);
+  TEST_ASSERT_EQUAL_STRING("+9.9E+37\r\n", buffer);
+
+  // overflow and unit are packed above the digits
+  config.format = FORMAT_BURST;
+  print_output(buffer, &config, &average, &burst, 0x999999U, 0, true, NoUnit,
+               0U, 0U);
+  TEST_ASSERT_EQUAL_HEX32(0xc0999999U, burst.previous);
+}
+
+void test_si_average(void) {
+  struct si_average average = {0, 0U, false, {0, 0, SI_NONE}};
+  struct si_value mean;
+  bool overload;
+  TEST_ASSERT_TRUE(si_average_add(&average, (struct si_value){-5, 3, SI_HERTZ},
+                                  false, 0U, &mean, &overload));
+  TEST_ASSERT_EQUAL_INT32(-5, mean.value);
+  TEST_ASSERT_EQUAL_INT8(3, mean.exponent);
+
+  // rounded towards zero
+  const i32 values[] = {-10, -11, -11, -11};
+  for (size_t i = 0U; i < 3U; ++i) {
+    TEST_ASSERT_FALSE(si_average_add(&average,
+                                     (struct si_value){values[i], 3, SI_HERTZ},
+                                     false, 2U, &mean, &overload));
+  }
+  TEST_ASSERT_TRUE(si_average_add(&average,
+                                  (struct si_value){values[3], 3, SI_HERTZ},
+                                  false, 2U, &mean, &overload));
+  TEST_ASSERT_EQUAL_INT32(-10, mean.value);
+  TEST_ASSERT_FALSE(overload);
+
+  // a change of range starts over, an overload spoils the block
+  TEST_ASSERT_FALSE(si_average_add(&average,
+                                   (struct si_value){999999, 3, SI_HERTZ},
+                                   true, 1U, &mean, &overload));
+  TEST_ASSERT_FALSE(si_average_add(&average,
+                                   (struct si_value){99999, 2, SI_HERTZ},
+                                   false, 1U, &mean, &overload));
+  TEST_ASSERT_TRUE(si_average_add(&average,
+                                  (struct si_value){100001, 2, SI_HERTZ},
+                                  true, 1U, &mean, &overload));
+  TEST_ASSERT_EQUAL_INT32(100000, mean.value);
+  TEST_ASSERT_EQUAL_INT8(2, mean.exponent);
+  TEST_ASSERT_TRUE(overload);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bcd_to_binary);
+  RUN_TEST(test_reading_to_si);
+  RUN_TEST(test_print_nr3);
+  RUN_TEST(test_print_output);
+  RUN_TEST(test_si_average);
+  return UNITY_END();
+}